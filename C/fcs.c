@@ -1,5 +1,50 @@
 #include "fcs.h"
 
+#if (defined(FCS_BYTE_TABLE) + defined(FCS_NIBBLE_TABLE) + defined(FCS_BITWISE)) > 1
+#error "Only one of FCS_BYTE_TABLE, FCS_NIBBLE_TABLE and FCS_BITWISE can be defined"
+#endif
+
+#if defined(FCS_BITWISE)
+/*
+ *    Bitwise calculation without lookup table (smallest, slowest)
+ *    Polynomial:   Reflected
+ */
+#ifdef CRC32
+#define FCS_POLYNOMIAL 0xEDB88320
+#else
+#define FCS_POLYNOMIAL 0x8408
+#endif
+
+FCS_SIZE calc_fcs(FCS_SIZE fcs, unsigned char value) {
+  int i;
+
+  fcs ^= value;
+  for (i = 0; i < 8; i++) {
+    fcs = (fcs & 1) ? ((fcs >> 1) ^ FCS_POLYNOMIAL) : (fcs >> 1);
+  }
+
+  return fcs;
+}
+#elif defined(FCS_NIBBLE_TABLE)
+/*
+ *    Lookup Table: Reflected, 16 entries (one nibble at a time)
+ */
+#ifdef CRC32
+static const unsigned int fcstab[16] = {
+0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+#else
+static const unsigned short fcstab[16] = { 0x0000, 0x1081, 0x2102, 0x3183,
+    0x4204, 0x5285, 0x6306, 0x7387, 0x8408, 0x9489, 0xa50a, 0xb58b, 0xc60c,
+    0xd68d, 0xe70e, 0xf78f };
+#endif
+
+FCS_SIZE calc_fcs(FCS_SIZE fcs, unsigned char value) {
+  fcs = (fcs >> 4) ^ fcstab[(fcs ^ value) & 0xf];
+  return (fcs >> 4) ^ fcstab[(fcs ^ (value >> 4)) & 0xf];
+}
+#else // FCS_BYTE_TABLE (default)
 #ifdef CRC32
 /*
  *    CRC-Type:     CRC32 (IEEE 802.3 - Ethernet)
@@ -82,3 +127,4 @@ static const unsigned short fcstab[256] = { 0x0000, 0x1189, 0x2312, 0x329b,
 FCS_SIZE calc_fcs(FCS_SIZE fcs, unsigned char value) {
   return (fcs >> 8) ^ fcstab[(fcs ^ value) & 0xff];
 }
+#endif
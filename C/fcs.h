@@ -5,6 +5,14 @@
 #ifndef FCS_H
 #define FCS_H
 
+/*
+ * The FCS is calculated with a 256 entry lookup table by default (which can
+ * also be selected explicitly with FCS_BYTE_TABLE). Define FCS_NIBBLE_TABLE to
+ * use a 16 entry lookup table, or FCS_BITWISE to calculate it without lookup
+ * table, to trade speed for a smaller footprint (see the bench target in test
+ * for the speed and size of each variant).
+ */
+
 #ifdef CRC32
     #define FCS_INIT_VALUE 0xFFFFFFFF /* FCS initialization value. */
     #define FCS_GOOD_VALUE 0xDEBB20E3 /* FCS value for valid frames. */
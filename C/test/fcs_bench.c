@@ -0,0 +1,81 @@
+/**
+ * @file fcs_bench.c
+ *
+ * Checks and measures the FCS implementation it is linked with
+ * (see FCS_NIBBLE_TABLE and FCS_BITWISE in fcs.h)
+ */
+
+#include "fcs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define BENCH_DATA_SIZE 4096
+#define BENCH_ITERATIONS 2000
+
+#ifdef CRC32
+#define BENCH_CHECK_VALUE 0xCBF43926
+#else
+#define BENCH_CHECK_VALUE 0x906E
+#endif
+
+static double bench_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static unsigned long long bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  int i, j;
+  double start, elapsed;
+  unsigned long long cycles;
+  FCS_SIZE fcs = FCS_INIT_VALUE;
+  const char *check = "123456789";
+  static unsigned char data[BENCH_DATA_SIZE];
+
+  // Verify the implementation with the standard check value
+  for (i = 0; check[i]; i++) {
+    fcs = calc_fcs(fcs, check[i]);
+  }
+  fcs ^= FCS_INVERT_MASK;
+  if (fcs != BENCH_CHECK_VALUE) {
+    fprintf(stderr, "Invalid FCS check value 0x%X\n", (unsigned int) fcs);
+    return 1;
+  }
+
+  for (i = 0; i < BENCH_DATA_SIZE; i++) {
+    data[i] = (unsigned char) rand();
+  }
+
+  fcs = FCS_INIT_VALUE;
+  start = bench_now();
+  cycles = bench_cycles();
+  for (j = 0; j < BENCH_ITERATIONS; j++) {
+    for (i = 0; i < BENCH_DATA_SIZE; i++) {
+      fcs = calc_fcs(fcs, data[i]);
+    }
+  }
+  cycles = bench_cycles() - cycles;
+  elapsed = bench_now() - start;
+
+  // The name and object size of the variant are given by the bench target
+  printf("%-16s %6s bytes  %6.2f ns/B  %6.2f cycles/B  (0x%X)\n",
+         (argc > 1) ? argv[1] : "calc_fcs", (argc > 2) ? argv[2] : "-",
+         1e9 * elapsed / ((double) BENCH_ITERATIONS * BENCH_DATA_SIZE),
+         (double) cycles / ((double) BENCH_ITERATIONS * BENCH_DATA_SIZE),
+         (unsigned int) fcs);
+
+  return 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file yahdlc_bench.c
+ *
+ * Compares the wire size and encode/decode time of the byte stuffing methods,
+ * and the decode time of many links with separate states and with the
+ * multi-link decoder, the throughput of the bit-oriented codec and of the
+ * parallel decoder with different numbers of threads
+ */
+
+#include "yahdlc.h"
+#include "yahdlc_multilink.h"
+#include "yahdlc_bit.h"
+#include "yahdlc_parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_DATA_SIZE 1024
+#define BENCH_ITERATIONS 20000
+
+typedef int (*bench_frame_fn)(yahdlc_control_t *, const char *, unsigned int,
+                              char *, unsigned int *);
+
+static double bench_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void bench_stuffing(const char *name, const char *data,
+                           const char *method, bench_frame_fn frame_fn) {
+  int i;
+  double start, encode, decode;
+  yahdlc_state_t state;
+  yahdlc_control_t control = { YAHDLC_FRAME_DATA, 0 };
+  unsigned int frame_length = 0, recv_length = 0;
+  static char frame_data[(2 * BENCH_DATA_SIZE) + 16], recv_data[sizeof(frame_data)];
+
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++) {
+    frame_fn(&control, data, BENCH_DATA_SIZE, frame_data, &frame_length);
+  }
+  encode = bench_now() - start;
+
+  yahdlc_get_data_reset_with_state(&state);
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++) {
+    yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                               recv_data, &recv_length);
+  }
+  decode = bench_now() - start;
+
+  printf("%-8s %-8s %6u wire bytes (%+6.1f%%)  encode %5.2f ns/B  decode %5.2f ns/B\n",
+         name, method, frame_length,
+         100.0 * ((double) frame_length - BENCH_DATA_SIZE) / BENCH_DATA_SIZE,
+         1e9 * encode / ((double) BENCH_ITERATIONS * BENCH_DATA_SIZE),
+         1e9 * decode / ((double) BENCH_ITERATIONS * BENCH_DATA_SIZE));
+}
+
+#define BENCH_LINKS 4096
+#define BENCH_LINK_DATA_SIZE 32
+#define BENCH_LINK_CHUNK_SIZE 8
+#define BENCH_LINK_ITERATIONS 200
+
+static void bench_multilink_frame(void *arg, unsigned int link,
+                                  unsigned char address,
+                                  const yahdlc_control_t *control,
+                                  const char *data, unsigned int data_len,
+                                  int status) {
+  (void) link;
+  (void) address;
+  (void) control;
+  (void) data;
+  (void) data_len;
+  *(unsigned int *) arg += (status == 0);
+}
+
+// Best of a few runs, as the time of a single run varies a lot with the cache
+// and frequency state of the machine
+#define BENCH_LINK_RUNS 5
+
+static void bench_links(const char *data) {
+  int i, run, ret;
+  unsigned int link, offset, chunk, frames = 0, recv_length;
+  size_t multi_size;
+  double start, single = 0, multi = 0, elapsed;
+  char frame_data[(2 * BENCH_LINK_DATA_SIZE) + 16], recv_data[sizeof(frame_data)];
+  unsigned int frame_length;
+  yahdlc_control_t control = { YAHDLC_FRAME_DATA, 0 };
+  yahdlc_multilink_t multilink;
+  yahdlc_state_t *states = malloc(BENCH_LINKS * sizeof(yahdlc_state_t));
+  yahdlc_multilink_input_t *inputs = malloc(BENCH_LINKS * sizeof(yahdlc_multilink_input_t));
+
+  // Every link receives the same frame in small chunks, one chunk per link at a time
+  yahdlc_frame_data(&control, data, BENCH_LINK_DATA_SIZE, frame_data, &frame_length);
+  for (link = 0; link < BENCH_LINKS; link++) {
+    yahdlc_get_data_reset_with_state(&states[link]);
+  }
+
+  for (run = 0; run < BENCH_LINK_RUNS; run++) {
+    start = bench_now();
+    for (i = 0; i < BENCH_LINK_ITERATIONS; i++) {
+      for (offset = 0; offset < frame_length; offset += chunk) {
+        chunk = frame_length - offset;
+        if (chunk > BENCH_LINK_CHUNK_SIZE) {
+          chunk = BENCH_LINK_CHUNK_SIZE;
+        }
+        for (link = 0; link < BENCH_LINKS; link++) {
+          ret = yahdlc_get_data_with_state(&states[link], &control,
+                                           &frame_data[offset], chunk,
+                                           recv_data, &recv_length);
+          frames += (ret >= 0);
+        }
+      }
+    }
+    elapsed = bench_now() - start;
+    if (!run || (elapsed < single)) {
+      single = elapsed;
+    }
+  }
+
+  yahdlc_multilink_init(&multilink, BENCH_LINKS, BENCH_LINK_DATA_SIZE);
+  for (run = 0; run < BENCH_LINK_RUNS; run++) {
+    start = bench_now();
+    for (i = 0; i < BENCH_LINK_ITERATIONS; i++) {
+      for (offset = 0; offset < frame_length; offset += chunk) {
+        chunk = frame_length - offset;
+        if (chunk > BENCH_LINK_CHUNK_SIZE) {
+          chunk = BENCH_LINK_CHUNK_SIZE;
+        }
+        for (link = 0; link < BENCH_LINKS; link++) {
+          inputs[link].link = link;
+          inputs[link].src = &frame_data[offset];
+          inputs[link].src_len = chunk;
+        }
+        yahdlc_multilink_get_data(&multilink, inputs, BENCH_LINKS,
+                                  bench_multilink_frame, &frames);
+      }
+    }
+    elapsed = bench_now() - start;
+    if (!run || (elapsed < multi)) {
+      multi = elapsed;
+    }
+  }
+
+  // The state arrays of a link plus its buffer, which holds the frame data
+  // and FCS (the single state decoder writes the data to the caller's buffer)
+  multi_size = sizeof(*multilink.fcs) + sizeof(*multilink.index)
+      + sizeof(*multilink.flags) + sizeof(*multilink.address)
+      + sizeof(*multilink.control);
+  printf("%d links  state %zu B/link  decode %5.2f ns/B   multi-link %zu+%zu B/link  decode %5.2f ns/B  (%u frames)\n",
+         BENCH_LINKS, sizeof(yahdlc_state_t),
+         1e9 * single / ((double) BENCH_LINK_ITERATIONS * BENCH_LINKS * frame_length),
+         multi_size, multilink.buffer_size + sizeof(FCS_SIZE),
+         1e9 * multi / ((double) BENCH_LINK_ITERATIONS * BENCH_LINKS * frame_length),
+         frames);
+  yahdlc_multilink_free(&multilink);
+
+  free(states);
+  free(inputs);
+}
+
+static void bench_bit_frame(void *arg, unsigned char address,
+                            const yahdlc_control_t *control, const char *data,
+                            unsigned int data_len, int status) {
+  (void) address;
+  (void) control;
+  (void) data;
+  (void) data_len;
+  *(unsigned int *) arg += (status == 0);
+}
+
+static void bench_bit_stuffing(const char *name, const char *data) {
+  int i;
+  double start, encode, decode;
+  unsigned int frame_length = 0, frames = 0;
+  yahdlc_bit_encoder_t encoder;
+  yahdlc_bit_decoder_t decoder;
+  yahdlc_control_t control = { YAHDLC_FRAME_DATA, 0 };
+  static char frame_data[(2 * BENCH_DATA_SIZE) + 16], recv_data[sizeof(frame_data)];
+
+  yahdlc_bit_init();
+  yahdlc_bit_encoder_init(&encoder);
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++) {
+    yahdlc_bit_frame_data(&encoder, &control, data, BENCH_DATA_SIZE,
+                          frame_data, &frame_length);
+  }
+  encode = bench_now() - start;
+  frame_length += yahdlc_bit_flush(&encoder, &frame_data[frame_length]);
+
+  yahdlc_bit_decoder_init(&decoder, recv_data, sizeof(recv_data));
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++) {
+    yahdlc_bit_get_data(&decoder, frame_data, frame_length, bench_bit_frame,
+                        &frames);
+  }
+  decode = bench_now() - start;
+
+  printf("%-8s %-8s %6u wire bytes (%+6.1f%%)  encode %5.0f Mbit/s  decode %5.0f Mbit/s  (%u frames)\n",
+         name, "bits", frame_length,
+         100.0 * ((double) frame_length - BENCH_DATA_SIZE) / BENCH_DATA_SIZE,
+         8.0 * BENCH_ITERATIONS * frame_length / encode / 1e6,
+         8.0 * BENCH_ITERATIONS * frame_length / decode / 1e6, frames);
+}
+
+#define BENCH_PARALLEL_SIZE (64 * 1024 * 1024)
+#define BENCH_PARALLEL_ITERATIONS 4
+
+static void bench_parallel(const char *data) {
+  int i;
+  long ret;
+  double start, elapsed;
+  size_t src_len = 0;
+  unsigned int j, valid, threads, frame_length, frames_len = 0;
+  yahdlc_control_t control = { YAHDLC_FRAME_DATA, 0 };
+  char *src = malloc(BENCH_PARALLEL_SIZE);
+  char *dest = malloc(BENCH_PARALLEL_SIZE);
+  unsigned int frames_size = BENCH_PARALLEL_SIZE / BENCH_DATA_SIZE;
+  yahdlc_frame_info_t *frames = malloc(frames_size * sizeof(yahdlc_frame_info_t));
+
+  // Fill the buffer with as many frames as fit
+  while ((src_len + (2 * BENCH_DATA_SIZE) + 16) <= BENCH_PARALLEL_SIZE) {
+    yahdlc_frame_data(&control, data, BENCH_DATA_SIZE, &src[src_len],
+                      &frame_length);
+    src_len += frame_length;
+  }
+
+  for (threads = 1; threads <= 8; threads *= 2) {
+    start = bench_now();
+    for (i = 0; i < BENCH_PARALLEL_ITERATIONS; i++) {
+      frames_len = frames_size;
+      ret = yahdlc_get_data_parallel(src, src_len, dest, frames, &frames_len,
+                                     threads, 0);
+      if (ret < 0) {
+        frames_len = 0;
+        break;
+      }
+    }
+    elapsed = bench_now() - start;
+
+    for (valid = 0, j = 0; j < frames_len; j++) {
+      valid += !frames[j].status;
+    }
+
+    printf("%u threads  decode %7.1f MB/s  (%u of %u frames valid)\n", threads,
+           (double) BENCH_PARALLEL_ITERATIONS * src_len / elapsed / 1e6, valid,
+           frames_len);
+  }
+
+  free(src);
+  free(dest);
+  free(frames);
+}
+
+int main(void) {
+  int i, j;
+  static char data[3][BENCH_DATA_SIZE];
+  const char *names[3] = { "text", "random", "flags" };
+
+  for (i = 0; i < BENCH_DATA_SIZE; i++) {
+    data[0][i] = (char) (0x20 + (rand() % 0x50));
+    data[1][i] = (char) rand();
+    data[2][i] = (i % 2) ? YAHDLC_FLAG_SEQUENCE : YAHDLC_CONTROL_ESCAPE;
+  }
+
+  printf("Byte stuffing of %d byte DATA frames\n", BENCH_DATA_SIZE);
+  for (j = 0; j < 3; j++) {
+    bench_stuffing(names[j], data[j], "escape", yahdlc_frame_data);
+    bench_stuffing(names[j], data[j], "cobs", yahdlc_frame_data_cobs);
+  }
+
+  printf("\nBit stuffing of %d byte DATA frames\n", BENCH_DATA_SIZE);
+  for (j = 0; j < 3; j++) {
+    bench_bit_stuffing(names[j], data[j]);
+  }
+
+  printf("\nDecoding of %d byte DATA frames received in %d byte chunks\n",
+         BENCH_LINK_DATA_SIZE, BENCH_LINK_CHUNK_SIZE);
+  bench_links(data[0]);
+
+  printf("\nParallel decoding of %d MiB of %d byte DATA frames (%ld cores online)\n",
+         BENCH_PARALLEL_SIZE / (1024 * 1024), BENCH_DATA_SIZE,
+         sysconf(_SC_NPROCESSORS_ONLN));
+  bench_parallel(data[0]);
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE yahdlc_coro
+#include <boost/test/unit_test.hpp>
+#include "yahdlc.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Counts the heap allocations to check that the coroutines of a link use its
+// frame slots instead of falling back to the heap
+static std::size_t test_allocations = 0;
+
+void *operator new(std::size_t size) {
+  void *memory = std::malloc(size ? size : 1);
+
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+
+  test_allocations++;
+  return memory;
+}
+
+void operator delete(void *memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+// Byte stream returning the input in chunks, either at once or when resumed
+struct test_stream {
+  std::vector<char> input;
+  std::vector<char> output;
+  size_t position = 0;
+  size_t chunk = 3;
+  bool deferred = false;
+  std::coroutine_handle<> pending;
+
+  struct read_awaiter {
+    test_stream &stream;
+    std::span<char> buffer;
+
+    bool await_ready() {
+      return !stream.deferred;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      stream.pending = handle;
+    }
+
+    size_t await_resume() {
+      size_t len = std::min(std::min(stream.chunk, buffer.size()),
+                            stream.input.size() - stream.position);
+      memcpy(buffer.data(), &stream.input[stream.position], len);
+      stream.position += len;
+      return len;
+    }
+  };
+
+  read_awaiter async_read_some(std::span<char> buffer) {
+    return read_awaiter{ *this, buffer };
+  }
+
+  std::suspend_never async_write(std::span<const char> buffer) {
+    output.insert(output.end(), buffer.begin(), buffer.end());
+    return {};
+  }
+};
+
+BOOST_AUTO_TEST_CASE(yahdlcTestCoroutines) {
+  test_stream stream;
+  yahdlc::link<test_stream, 64> link(stream);
+  yahdlc_control_t control;
+  char send_data[64];
+  unsigned int i;
+  std::size_t allocations;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+  send_data[0] = YAHDLC_FLAG_SEQUENCE;
+
+  // Send two frames and a frame which is too large. The coroutines of the
+  // link use its frame slots, so they must not allocate.
+  stream.output.reserve(1024);
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i < 2; i++) {
+    control.seq_no = i;
+    allocations = test_allocations;
+    auto send = link.send(control, std::span<const char>(send_data, sizeof(send_data) - i));
+    send.start();
+    allocations = test_allocations - allocations;
+    BOOST_CHECK_EQUAL(allocations, 0u);
+    BOOST_CHECK(send.done());
+    BOOST_CHECK_EQUAL(send.result(), 0);
+  }
+  allocations = test_allocations;
+  auto too_large = link.send(control, std::span<const char>(send_data, 65));
+  too_large.start();
+  allocations = test_allocations - allocations;
+  BOOST_CHECK_EQUAL(allocations, 0u);
+  BOOST_CHECK_EQUAL(too_large.result(), -EINVAL);
+
+  // Receive the frames in small chunks from a coroutine awaiting the link
+  stream.input = stream.output;
+  auto receive = [&]() -> yahdlc::task<int> {
+    int frames = 0;
+
+    for (;;) {
+      yahdlc::frame frame = co_await link.receive_frame();
+      if (frame.status) {
+        BOOST_CHECK_EQUAL(frame.status, -EPIPE);
+        co_return frames;
+      }
+
+      BOOST_CHECK_EQUAL(frame.control.frame, YAHDLC_FRAME_DATA);
+      BOOST_CHECK_EQUAL(frame.control.seq_no, frames);
+      BOOST_CHECK_EQUAL(frame.data.size(), sizeof(send_data) - frames);
+      BOOST_CHECK_EQUAL(memcmp(frame.data.data(), send_data, frame.data.size()), 0);
+      frames++;
+    }
+  };
+  // Coroutines which are not members of a link are allocated on the heap
+  allocations = test_allocations;
+  auto frames = receive();
+  allocations = test_allocations - allocations;
+  BOOST_CHECK_EQUAL(allocations, 1u);
+  frames.start();
+  BOOST_CHECK(frames.done());
+  BOOST_CHECK_EQUAL(frames.result(), 2);
+
+  // Receive a frame from a stream which completes the reads later
+  stream.input = stream.output;
+  stream.position = 0;
+  stream.chunk = 16;
+  stream.deferred = true;
+  allocations = test_allocations;
+  auto frame = link.receive_frame();
+  frame.start();
+  for (i = 0; !frame.done() && (i < 100); i++) {
+    stream.pending.resume();
+  }
+  allocations = test_allocations - allocations;
+  BOOST_CHECK_EQUAL(allocations, 0u);
+  BOOST_CHECK(frame.done());
+  BOOST_CHECK_EQUAL(frame.result().status, 0);
+}
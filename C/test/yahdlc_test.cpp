@@ -2,6 +2,19 @@
 #define BOOST_TEST_MODULE yahdlc
 #include <boost/test/unit_test.hpp>
 #include "yahdlc.h"
+#include "yahdlc_parallel.h"
+#include "yahdlc_capture.h"
+#include "yahdlc_compress.h"
+#include "yahdlc_fragment.h"
+#include "yahdlc_sched.h"
+#include "yahdlc_multilink.h"
+#include "yahdlc_bit.h"
+#include "yahdlc_shm.h"
+#include "yahdlc_cache.h"
+#include "yahdlc_xid.h"
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
 
 BOOST_AUTO_TEST_CASE(yahdlcTestFrameDataInvalidInputs) {
   int ret;
@@ -513,3 +526,1237 @@ BOOST_AUTO_TEST_CASE(yahdlcTestFramesWithBitErrors) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(yahdlcTestGetDataParallel) {
+  long ret;
+  yahdlc_control_t control;
+  yahdlc_frame_info_t frames[128];
+  char send_data[64], frame_data[100 * 140], recv_data[sizeof(frame_data)];
+  unsigned int i, frame_length = 0, frames_len, frame_index = 0, frames_count = 100;
+
+  // Initialize data to be send with random values including values to be escaped
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) (rand() % 0x80);
+  }
+
+  // Create frames with varying data length and sequence number
+  for (i = 0; i < frames_count; i++) {
+    control.frame = YAHDLC_FRAME_DATA;
+    control.seq_no = i;
+    ret = yahdlc_frame_data(&control, send_data, i % sizeof(send_data),
+                            &frame_data[frame_index], &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    frame_index += frame_length;
+  }
+
+  // Add a partial frame at the end which should not be discarded
+  frame_data[frame_index++] = YAHDLC_FLAG_SEQUENCE;
+  frame_data[frame_index++] = (char) YAHDLC_ALL_STATION_ADDR;
+
+  // Decode using small chunks so that the buffer is partitioned many times. The
+  // doubled flag sequence before the partial frame ends the last frame.
+  frames_len = sizeof(frames) / sizeof(frames[0]);
+  ret = yahdlc_get_data_parallel(frame_data, frame_index, recv_data, frames,
+                                 &frames_len, 4, 100);
+  BOOST_CHECK_EQUAL(ret, frame_index - 2);
+  BOOST_CHECK_EQUAL(frames_len, frames_count);
+
+  for (i = 0; i < frames_len; i++) {
+    BOOST_CHECK_EQUAL(frames[i].status, 0);
+    BOOST_CHECK_EQUAL(frames[i].control.seq_no, i % 8);
+    BOOST_CHECK_EQUAL(frames[i].length, i % sizeof(send_data));
+    BOOST_CHECK_EQUAL(memcmp(&recv_data[frames[i].offset], send_data, frames[i].length), 0);
+  }
+
+  // Decode as a single chunk whose frames grow past the initial allocation
+  frames_len = sizeof(frames) / sizeof(frames[0]);
+  ret = yahdlc_get_data_parallel(frame_data, frame_index, recv_data, frames,
+                                 &frames_len, 1, 0);
+  BOOST_CHECK_EQUAL(ret, frame_index - 2);
+  BOOST_CHECK_EQUAL(frames_len, frames_count);
+  BOOST_CHECK_EQUAL(frames[frames_count - 1].control.seq_no, (frames_count - 1) % 8);
+
+  // Check that a too small frames array is reported
+  frames_len = frames_count - 1;
+  ret = yahdlc_get_data_parallel(frame_data, frame_index, recv_data, frames,
+                                 &frames_len, 0, 0);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+
+  ret = yahdlc_get_data_parallel(NULL, frame_index, recv_data, frames,
+                                 &frames_len, 0, 0);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestCapture) {
+  int ret;
+  long frame;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+  yahdlc_capture_writer_t writer;
+  yahdlc_capture_reader_t reader;
+  yahdlc_capture_record_t record;
+  char send_data[32], frame_data[80], recv_data[80];
+  unsigned int i, frame_length = 0, recv_length = 0, frames = 10;
+  const char *path = "yahdlc_test.cap";
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) (rand() % 0x80);
+  }
+
+  ret = yahdlc_capture_writer_open(&writer, path);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // Decode frames with increasing timestamps and data length into the capture
+  yahdlc_get_data_reset_with_state(&state);
+  for (i = 0; i < frames; i++) {
+    control.frame = (i % 2) ? YAHDLC_FRAME_ACK : YAHDLC_FRAME_DATA;
+    control.seq_no = i;
+    ret = yahdlc_frame_data(&control, send_data, i, frame_data, &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+
+    ret = yahdlc_capture_get_data(&writer, i * 10, &state, &control, frame_data,
+                                  frame_length, recv_data, &recv_length);
+    BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  }
+
+  ret = yahdlc_capture_writer_close(&writer);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // Read back the frames in random order
+  ret = yahdlc_capture_reader_open(&reader, path);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(reader.frames, frames);
+
+  for (i = frames; i > 0; i--) {
+    ret = yahdlc_capture_read(&reader, i - 1, &record);
+    BOOST_CHECK_EQUAL(ret, 0);
+    BOOST_CHECK_EQUAL(record.timestamp, (i - 1) * 10);
+    BOOST_CHECK_EQUAL(record.address, YAHDLC_ALL_STATION_ADDR);
+    BOOST_CHECK_EQUAL(record.control.frame, ((i - 1) % 2) ? YAHDLC_FRAME_ACK : YAHDLC_FRAME_DATA);
+    BOOST_CHECK_EQUAL(record.control.seq_no, (i - 1) % 8);
+
+    // Only DATA frames contain data
+    if (record.control.frame == YAHDLC_FRAME_DATA) {
+      BOOST_CHECK_EQUAL(record.length, i - 1);
+      BOOST_CHECK_EQUAL(memcmp(record.data, send_data, record.length), 0);
+    } else {
+      BOOST_CHECK_EQUAL(record.length, 0);
+    }
+  }
+
+  ret = yahdlc_capture_read(&reader, frames, &record);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+
+  // Find frames by timestamp
+  frame = yahdlc_capture_find(&reader, 0);
+  BOOST_CHECK_EQUAL(frame, 0);
+  frame = yahdlc_capture_find(&reader, 45);
+  BOOST_CHECK_EQUAL(frame, 5);
+  frame = yahdlc_capture_find(&reader, 90);
+  BOOST_CHECK_EQUAL(frame, 9);
+  frame = yahdlc_capture_find(&reader, 91);
+  BOOST_CHECK_EQUAL(frame, -ENOMSG);
+
+  yahdlc_capture_reader_close(&reader);
+  remove(path);
+  remove("yahdlc_test.cap.idx");
+
+  // A corrupt index offset close to the maximum must not wrap the bounds check
+  unsigned char index[YAHDLC_CAPTURE_INDEX_ENTRY_SIZE];
+  memset(index, 0xFF, 8);
+  memset(&index[8], 0, 8);
+  memset(&reader, 0, sizeof(reader));
+  reader.data = index;
+  reader.data_size = sizeof(index);
+  reader.index = index;
+  reader.index_size = sizeof(index);
+  reader.frames = 1;
+  ret = yahdlc_capture_read(&reader, 0, &record);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  // All appends fail after a write error
+  static char large_data[64 * 1024];
+  ret = yahdlc_capture_writer_open(&writer, path);
+  BOOST_CHECK_EQUAL(ret, 0);
+  fclose(writer.data);
+  writer.data = fopen("/dev/full", "wb");
+  BOOST_REQUIRE(writer.data != NULL);
+  ret = yahdlc_capture_append(&writer, 0, YAHDLC_ALL_STATION_ADDR, &control,
+                              large_data, sizeof(large_data));
+  BOOST_CHECK_EQUAL(ret, -EIO);
+  ret = yahdlc_capture_append(&writer, 0, YAHDLC_ALL_STATION_ADDR, &control,
+                              NULL, 0);
+  BOOST_CHECK_EQUAL(ret, -EIO);
+  yahdlc_capture_writer_close(&writer);
+  remove(path);
+  remove("yahdlc_test.cap.idx");
+
+  // No files are left behind when the data or index file can not be created
+  ret = yahdlc_capture_writer_open(&writer, "yahdlc_test.missing/test.cap");
+  BOOST_CHECK_EQUAL(ret, -ENOENT);
+
+  BOOST_CHECK_EQUAL(mkdir("yahdlc_test.cap.idx", 0700), 0);
+  ret = yahdlc_capture_writer_open(&writer, path);
+  BOOST_CHECK_EQUAL(ret, -EISDIR);
+  BOOST_CHECK(access(path, F_OK) != 0);
+  rmdir("yahdlc_test.cap.idx");
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestCompress) {
+  int ret;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+  yahdlc_compress_t tx, rx;
+  char send_data[256], frame_data[600], recv_data[YAHDLC_COMPRESS_MAX_DATA];
+  unsigned int i, frame_length = 0, recv_length = 0;
+
+  yahdlc_compress_reset(&tx);
+  yahdlc_compress_reset(&rx);
+  yahdlc_get_data_reset_with_state(&state);
+
+  // Initialize repetitive data with a few values to be escaped
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) ((i % 16) + 0x70);
+  }
+
+  for (i = 0; i < 100; i++) {
+    // Change a single byte in each frame
+    send_data[i % sizeof(send_data)] = (char) i;
+
+    control.frame = YAHDLC_FRAME_DATA;
+    control.seq_no = i;
+    ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                     frame_data, &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+
+    // Frames should be smaller than the data, especially when the data is in the dictionary
+    BOOST_CHECK(frame_length < sizeof(send_data));
+    if (i > 0) {
+      BOOST_CHECK(frame_length < 32);
+    }
+
+    ret = yahdlc_compress_get_data(&rx, &state, &control, frame_data,
+                                   frame_length, recv_data, &recv_length);
+    BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+    BOOST_CHECK_EQUAL(recv_length, sizeof(send_data));
+    BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+  }
+
+  // Random data should be sent uncompressed
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                   frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_compress_get_data(&rx, &state, &control, frame_data,
+                                 frame_length, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  BOOST_CHECK_EQUAL(recv_length, sizeof(send_data));
+  BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+
+  // A lost frame should be detected as the dictionaries are out of sync
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                   frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                   frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_compress_get_data(&rx, &state, &control, frame_data,
+                                 frame_length, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, -EIO);
+  BOOST_CHECK_EQUAL(recv_length, frame_length - 1);
+
+  // After a reset of the sender the receiver is in sync again
+  yahdlc_compress_reset(&tx);
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                   frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_compress_get_data(&rx, &state, &control, frame_data,
+                                 frame_length, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+
+  // Data above the maximum size is not supported
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data,
+                                   YAHDLC_COMPRESS_MAX_DATA + 1, frame_data,
+                                   &frame_length);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  // A received frame too large for the context is dropped without affecting
+  // the following frame
+  std::vector<char> large_data(2000, 0x11), received(2 * 2000 + 600);
+  unsigned int received_length;
+  ret = yahdlc_frame_data(&control, large_data.data(), large_data.size(),
+                          received.data(), &received_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_compress_frame_data(&tx, &control, send_data, sizeof(send_data),
+                                   frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  memcpy(&received[received_length], frame_data, frame_length);
+  received_length += frame_length;
+
+  ret = yahdlc_compress_get_data(&rx, &state, &control, received.data(),
+                                 received_length, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+  BOOST_CHECK(recv_length < received_length);
+  ret = yahdlc_compress_get_data(&rx, &state, &control,
+                                 &received[recv_length],
+                                 received_length - recv_length, recv_data,
+                                 &recv_length);
+  BOOST_CHECK(ret > 0);
+  BOOST_CHECK_EQUAL(recv_length, sizeof(send_data));
+  BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+
+  // The data of XID frames is passed through without decompression
+  yahdlc_xid_params_t xid = { 256, 4, YAHDLC_XID_FCS_BITS, 1 }, received_xid;
+  ret = yahdlc_xid_frame_data(&xid, frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  memset(recv_data, 0, sizeof(recv_data));
+  ret = yahdlc_compress_get_data(&rx, &state, &control, frame_data,
+                                 frame_length, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  BOOST_CHECK_EQUAL(control.frame, YAHDLC_FRAME_XID);
+  BOOST_CHECK_EQUAL(recv_length, YAHDLC_XID_INFO_SIZE);
+  ret = yahdlc_xid_decode(recv_data, recv_length, &received_xid);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(received_xid.max_info, xid.max_info);
+  BOOST_CHECK_EQUAL(received_xid.window, xid.window);
+  BOOST_CHECK_EQUAL(received_xid.cobs, xid.cobs);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestCobsFrames) {
+  int ret;
+  yahdlc_control_t control_send, control_recv;
+  char send_data[600], frame_data[700], recv_data[700];
+  unsigned int i, j, frame_length = 0, recv_length = 0;
+
+  yahdlc_get_data_reset();
+
+  // Initialize data with many values to be escaped
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (rand() % 2) ? YAHDLC_FLAG_SEQUENCE : (char) (rand() % 0x80);
+  }
+
+  // Run through the different data sizes to cover full blocks
+  for (i = 0; i <= sizeof(send_data); i++) {
+    control_send.frame = YAHDLC_FRAME_DATA;
+    control_send.seq_no = i;
+    ret = yahdlc_frame_data_cobs(&control_send, send_data, i, frame_data,
+                                 &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+
+    // Overhead is the frame fields, the COBS marker and one code byte per 254 bytes
+    BOOST_CHECK(frame_length <= (i + 4 + sizeof(FCS_SIZE) + 2 + 1 + ((i + 2 + sizeof(FCS_SIZE)) / 254)));
+
+    // Flag sequence values must only be present at the start and end
+    for (j = 1; j < (frame_length - 1); j++) {
+      BOOST_CHECK(frame_data[j] != YAHDLC_FLAG_SEQUENCE);
+    }
+
+    ret = yahdlc_get_data(&control_recv, frame_data, frame_length, recv_data,
+                          &recv_length);
+    BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+    BOOST_CHECK_EQUAL(recv_length, i);
+    BOOST_CHECK_EQUAL(control_recv.seq_no, control_send.seq_no);
+    BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, i), 0);
+  }
+
+  // COBS frames can be received from multiple buffers
+  ret = yahdlc_frame_data_cobs(&control_send, send_data, sizeof(send_data),
+                               frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  for (i = 0; i < frame_length; i++) {
+    ret = yahdlc_get_data(&control_recv, &frame_data[i], 1, recv_data,
+                          &recv_length);
+  }
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(recv_length, sizeof(send_data));
+  BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+
+  // ACK frames do not contain data
+  control_send.frame = YAHDLC_FRAME_ACK;
+  ret = yahdlc_frame_data_cobs(&control_send, send_data, sizeof(send_data),
+                               frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_get_data(&control_recv, frame_data, frame_length, recv_data,
+                        &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  BOOST_CHECK_EQUAL(recv_length, 0);
+  BOOST_CHECK_EQUAL(control_recv.frame, YAHDLC_FRAME_ACK);
+
+  // A bit error in the code byte should result in an invalid FCS
+  control_send.frame = YAHDLC_FRAME_DATA;
+  ret = yahdlc_frame_data_cobs(&control_send, send_data, 32, frame_data,
+                               &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  frame_data[3] ^= 1;
+  ret = yahdlc_get_data(&control_recv, frame_data, frame_length, recv_data,
+                        &recv_length);
+  BOOST_CHECK_EQUAL(ret, -EIO);
+
+  ret = yahdlc_frame_data_cobs(NULL, send_data, 1, frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestFragmentation) {
+  int ret, fragments;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+  yahdlc_fragment_tx_t tx;
+  yahdlc_fragment_rx_t rx;
+  static char buffers[YAHDLC_FRAGMENT_MAX_MESSAGES][4096];
+  char send_data[3000], frame_data[YAHDLC_FRAGMENT_FRAME_SIZE(256)], recv_data[300], *msg;
+  unsigned int i, frame_length = 0, recv_length = 0, msg_len = 0;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+
+  ret = yahdlc_fragment_tx_init(&tx, 256);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_fragment_rx_init(&rx, 256, 100, &buffers[0][0], sizeof(buffers[0]));
+  BOOST_CHECK_EQUAL(ret, 0);
+  yahdlc_get_data_reset_with_state(&state);
+
+  fragments = yahdlc_fragment_tx_begin(&tx, send_data, sizeof(send_data));
+  BOOST_CHECK_EQUAL(fragments, 12);
+
+  // Send the fragments in reverse order with a retransmit of one fragment
+  for (i = fragments; i > 0; i--) {
+    control.frame = YAHDLC_FRAME_DATA;
+    ret = yahdlc_fragment_frame_data(&tx, &control, i - 1, frame_data, &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+
+    ret = yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                                     recv_data, &recv_length);
+    BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+
+    ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+    if (i == 5) {
+      ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+    }
+    BOOST_CHECK_EQUAL(ret, (i > 1) ? -EAGAIN : 0);
+  }
+
+  BOOST_CHECK_EQUAL(msg_len, sizeof(send_data));
+  BOOST_CHECK_EQUAL(memcmp(msg, send_data, sizeof(send_data)), 0);
+
+  // Retransmitted fragments of a delivered message neither deliver it again
+  // nor use a slot
+  for (i = 0; i < 2; i++) {
+    ret = yahdlc_fragment_frame_data(&tx, &control, i * (fragments - 1),
+                                     frame_data, &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                               recv_data, &recv_length);
+    ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+    BOOST_CHECK_EQUAL(ret, -EAGAIN);
+  }
+  BOOST_CHECK_EQUAL(yahdlc_fragment_expire(&rx, 1000), 0);
+
+  // Incomplete messages use a slot until they time out
+  for (i = 0; i < YAHDLC_FRAGMENT_MAX_MESSAGES + 1; i++) {
+    yahdlc_fragment_tx_begin(&tx, send_data, sizeof(send_data));
+    yahdlc_fragment_frame_data(&tx, &control, 0, frame_data, &frame_length);
+    yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                               recv_data, &recv_length);
+    ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 1000, &msg, &msg_len);
+    BOOST_CHECK_EQUAL(ret, (i < YAHDLC_FRAGMENT_MAX_MESSAGES) ? -EAGAIN : -ENOBUFS);
+  }
+
+  BOOST_CHECK_EQUAL(yahdlc_fragment_expire(&rx, 1050), 0);
+  BOOST_CHECK_EQUAL(yahdlc_fragment_expire(&rx, 1101), YAHDLC_FRAGMENT_MAX_MESSAGES);
+
+  // A last fragment before a received fragment drops the message at once
+  memset(recv_data, 0, sizeof(recv_data));
+  recv_data[0] = 7;
+  recv_data[1] = 3;
+  ret = yahdlc_fragment_receive(&rx, recv_data, 256 + YAHDLC_FRAGMENT_HEADER_SIZE, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -EAGAIN);
+  recv_data[1] = 1;
+  recv_data[2] = (char) (YAHDLC_FRAGMENT_LAST >> 8);
+  ret = yahdlc_fragment_receive(&rx, recv_data, 10 + YAHDLC_FRAGMENT_HEADER_SIZE, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -EIO);
+  BOOST_CHECK_EQUAL(yahdlc_fragment_expire(&rx, 1000), 0);
+
+  // Empty messages are sent as a single fragment
+  fragments = yahdlc_fragment_tx_begin(&tx, NULL, 0);
+  BOOST_CHECK_EQUAL(fragments, 1);
+  yahdlc_fragment_frame_data(&tx, &control, 0, frame_data, &frame_length);
+  yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                             recv_data, &recv_length);
+  ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(msg_len, 0);
+
+  // A retransmitted single fragment message is only delivered once
+  ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -EAGAIN);
+
+  // Messages larger than the buffer are rejected
+  fragments = yahdlc_fragment_tx_begin(&tx, send_data, sizeof(send_data));
+  ret = yahdlc_fragment_rx_init(&rx, 256, 100, &buffers[0][0], 1024);
+  BOOST_CHECK_EQUAL(ret, 0);
+  yahdlc_fragment_frame_data(&tx, &control, 4, frame_data, &frame_length);
+  yahdlc_get_data_with_state(&state, &control, frame_data, frame_length,
+                             recv_data, &recv_length);
+  ret = yahdlc_fragment_receive(&rx, recv_data, recv_length, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+
+  // Check invalid fragments and parameters
+  ret = yahdlc_fragment_receive(&rx, recv_data, 2, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  ret = yahdlc_fragment_receive(&rx, recv_data, recv_length - 1, 0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  ret = yahdlc_fragment_frame_data(&tx, &control, fragments, frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_fragment_tx_init(&tx, YAHDLC_FRAGMENT_SIZE_MAX + 1);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_fragment_tx_init(&tx, 1);
+  BOOST_CHECK_EQUAL(ret, 0);
+  fragments = yahdlc_fragment_tx_begin(&tx, send_data, YAHDLC_FRAGMENT_MAX_FRAGMENTS + 1);
+  BOOST_CHECK_EQUAL(fragments, -EINVAL);
+  ret = yahdlc_fragment_reset(&tx, &rx, 0);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_fragment_reset(&tx, &rx, YAHDLC_FRAGMENT_SIZE_MAX + 1);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestAbortSequence) {
+  int ret;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+  char send_data[16], frame_data[64], recv_data[64];
+  unsigned int i, frame_length = 0, recv_length = 0;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) (rand() % 0x70);
+  }
+
+  // Create an aborted frame followed by a complete frame
+  control.frame = YAHDLC_FRAME_DATA;
+  ret = yahdlc_frame_data(&control, send_data, sizeof(send_data), frame_data,
+                          &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  frame_data[8] = YAHDLC_CONTROL_ESCAPE;
+  frame_data[9] = YAHDLC_FLAG_SEQUENCE;
+  ret = yahdlc_frame_data(&control, send_data, sizeof(send_data),
+                          &frame_data[10], &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  frame_length += 10;
+
+  // The aborted frame should be silently discarded (also when split in multiple buffers)
+  yahdlc_get_data_reset_with_state(&state);
+  ret = yahdlc_get_data_with_state(&state, &control, frame_data, 9, recv_data,
+                                   &recv_length);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  ret = yahdlc_get_data_with_state(&state, &control, &frame_data[9],
+                                   frame_length - 9, recv_data, &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 10));
+  BOOST_CHECK_EQUAL(recv_length, sizeof(send_data));
+  BOOST_CHECK_EQUAL(memcmp(send_data, recv_data, sizeof(send_data)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestSchedulerPreemption) {
+  int ret;
+  yahdlc_sched_t sched;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+  yahdlc_sched_frame_t bulk, urgent;
+  char bulk_data[256], urgent_data[4], bulk_frame[600], urgent_frame[16];
+  char stream[1024], recv_data[600];
+  unsigned int i, bulk_length, urgent_length, stream_length, recv_length = 0;
+
+  for (i = 0; i < sizeof(bulk_data); i++) {
+    bulk_data[i] = (char) rand();
+  }
+  memset(urgent_data, 0x55, sizeof(urgent_data));
+
+  // Use the address field as channel id
+  control.frame = YAHDLC_FRAME_DATA;
+  yahdlc_frame_data_with_address(5, &control, bulk_data, sizeof(bulk_data),
+                                 bulk_frame, &bulk_length);
+  yahdlc_frame_data_with_address(1, &control, urgent_data, sizeof(urgent_data),
+                                 urgent_frame, &urgent_length);
+
+  yahdlc_sched_init(&sched);
+  ret = yahdlc_sched_submit(&sched, &bulk, bulk_frame, bulk_length, 3);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // Start sending the bulk frame and queue the urgent frame in the middle of it
+  stream_length = yahdlc_sched_pull(&sched, stream, 100);
+  BOOST_CHECK_EQUAL(stream_length, 100);
+  ret = yahdlc_sched_submit(&sched, &urgent, urgent_frame, urgent_length, 0);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // The bulk frame should be aborted, and sent again after the urgent frame
+  stream_length += yahdlc_sched_pull(&sched, &stream[stream_length], 1);
+  stream_length += yahdlc_sched_pull(&sched, &stream[stream_length],
+                                     sizeof(stream) - stream_length);
+  BOOST_CHECK_EQUAL(stream_length, 100 + YAHDLC_SCHED_ABORT_SIZE + urgent_length + bulk_length);
+  BOOST_CHECK(urgent.done);
+  BOOST_CHECK(bulk.done);
+  BOOST_CHECK_EQUAL(yahdlc_sched_pull(&sched, stream, sizeof(stream)), 0);
+
+  yahdlc_get_data_reset_with_state(&state);
+  ret = yahdlc_get_data_with_state(&state, &control, stream, stream_length,
+                                   recv_data, &recv_length);
+  BOOST_CHECK(ret > 0);
+  BOOST_CHECK_EQUAL(state.address, 1);
+  BOOST_CHECK_EQUAL(recv_length, sizeof(urgent_data));
+  BOOST_CHECK_EQUAL(memcmp(urgent_data, recv_data, sizeof(urgent_data)), 0);
+
+  ret = yahdlc_get_data_with_state(&state, &control, &stream[ret],
+                                   stream_length - ret, recv_data, &recv_length);
+  BOOST_CHECK(ret > 0);
+  BOOST_CHECK_EQUAL(state.address, 5);
+  BOOST_CHECK_EQUAL(recv_length, sizeof(bulk_data));
+  BOOST_CHECK_EQUAL(memcmp(bulk_data, recv_data, sizeof(bulk_data)), 0);
+
+  ret = yahdlc_sched_submit(&sched, &bulk, bulk_frame, bulk_length, YAHDLC_SCHED_PRIORITIES);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+#define MULTILINK_LINKS 64
+
+// Frames received by the multi-link decoder
+typedef struct {
+  unsigned int frames[MULTILINK_LINKS];
+  unsigned int errors;
+  unsigned int overflows;
+  const char *expected;
+  unsigned int expected_len;
+} multilink_result_t;
+
+static void multilink_frame(void *arg, unsigned int link, unsigned char address,
+                            const yahdlc_control_t *control, const char *data,
+                            unsigned int data_len, int status) {
+  multilink_result_t *result = (multilink_result_t *) arg;
+
+  if (status == -EIO) {
+    result->errors++;
+  } else if (status == -ENOBUFS) {
+    result->overflows++;
+  } else {
+    BOOST_CHECK_EQUAL(status, 0);
+    BOOST_CHECK_EQUAL(address, link);
+    BOOST_CHECK_EQUAL(control->frame, YAHDLC_FRAME_DATA);
+    BOOST_CHECK_EQUAL(control->seq_no, result->frames[link] % 8);
+    BOOST_CHECK_EQUAL(data_len, result->expected_len);
+    BOOST_CHECK_EQUAL(memcmp(data, result->expected, data_len), 0);
+    result->frames[link]++;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestMultiLink) {
+  int ret;
+  yahdlc_multilink_t multilink;
+  yahdlc_multilink_input_t inputs[2 * MULTILINK_LINKS];
+  yahdlc_control_t control;
+  multilink_result_t result;
+  char send_data[100], frame_data[MULTILINK_LINKS][3][256];
+  unsigned int i, j, inputs_len, offset[MULTILINK_LINKS], frame_length[MULTILINK_LINKS][3];
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+
+  memset(&result, 0, sizeof(result));
+  result.expected = send_data;
+  result.expected_len = sizeof(send_data);
+
+  ret = yahdlc_multilink_init(&multilink, 0, sizeof(send_data));
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_multilink_init(&multilink, MULTILINK_LINKS, sizeof(send_data));
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // Create three frames for each link using the address field as link id
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i < MULTILINK_LINKS; i++) {
+    for (j = 0; j < 3; j++) {
+      control.seq_no = j;
+      yahdlc_frame_data_with_address(i, &control, send_data, sizeof(send_data),
+                                     frame_data[i][j], &frame_length[i][j]);
+    }
+    offset[i] = 0;
+  }
+
+  // Corrupt the second frame of link 7
+  frame_data[7][1][10] ^= 1;
+
+  // Feed the frames of each link in chunks of different sizes, and use the
+  // same link twice in a batch so the chunks must be decoded in order
+  for (j = 0; j < 3; j++) {
+    inputs_len = 0;
+    for (i = 0; i < MULTILINK_LINKS; i++) {
+      unsigned int len = 1 + (i % 5) * 20;
+
+      if (len > frame_length[i][j]) {
+        len = frame_length[i][j];
+      }
+      inputs[inputs_len].link = i;
+      inputs[inputs_len].src = frame_data[i][j];
+      inputs[inputs_len++].src_len = len;
+      offset[i] = len;
+    }
+    for (i = 0; i < MULTILINK_LINKS; i++) {
+      inputs[inputs_len].link = i;
+      inputs[inputs_len].src = &frame_data[i][j][offset[i]];
+      inputs[inputs_len++].src_len = frame_length[i][j] - offset[i];
+    }
+
+    ret = yahdlc_multilink_get_data(&multilink, inputs, inputs_len,
+                                    multilink_frame, &result);
+    BOOST_CHECK_EQUAL(ret, MULTILINK_LINKS - ((j == 1) ? 1 : 0));
+    if (j == 1) {
+      // Keep the expected sequence number of link 7 in sync
+      result.frames[7]++;
+    }
+  }
+
+  for (i = 0; i < MULTILINK_LINKS; i++) {
+    BOOST_CHECK_EQUAL(result.frames[i], 3);
+  }
+  BOOST_CHECK_EQUAL(result.errors, 1);
+
+  // Frames larger than the link buffer are dropped
+  yahdlc_frame_data_with_address(3, &control, frame_data[0][0], 200,
+                                 frame_data[1][0], &frame_length[1][0]);
+  inputs[0].link = 3;
+  inputs[0].src = frame_data[1][0];
+  inputs[0].src_len = frame_length[1][0];
+  ret = yahdlc_multilink_get_data(&multilink, inputs, 1, multilink_frame, &result);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(result.overflows, 1);
+
+  // Nothing is decoded when one of the inputs is invalid
+  inputs[1].link = MULTILINK_LINKS;
+  ret = yahdlc_multilink_get_data(&multilink, inputs, 2, multilink_frame, &result);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  yahdlc_multilink_free(&multilink);
+}
+
+// Frames received by the bit-oriented decoder
+typedef struct {
+  unsigned int frames;
+  unsigned int errors;
+  const char *expected;
+  unsigned int expected_len;
+} bit_result_t;
+
+static void bit_frame(void *arg, unsigned char address,
+                      const yahdlc_control_t *control, const char *data,
+                      unsigned int data_len, int status) {
+  bit_result_t *result = (bit_result_t *) arg;
+
+  if (status) {
+    result->errors++;
+    return;
+  }
+
+  BOOST_CHECK_EQUAL(address, YAHDLC_ALL_STATION_ADDR);
+  BOOST_CHECK_EQUAL(control->frame, YAHDLC_FRAME_DATA);
+  BOOST_CHECK_EQUAL(control->seq_no, result->frames % 8);
+  BOOST_CHECK_EQUAL(data_len, result->expected_len);
+  BOOST_CHECK_EQUAL(memcmp(data, result->expected, data_len), 0);
+  result->frames++;
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestBitStuffing) {
+  int ret;
+  yahdlc_bit_encoder_t encoder;
+  yahdlc_bit_decoder_t decoder;
+  yahdlc_control_t control;
+  bit_result_t result;
+  char send_data[64], buffer[128], stream[1024], shifted[1024];
+  unsigned int i, j, shift, stream_length = 0, frame_length;
+
+  // Use runs of ones (and flag sequence values) which need bit stuffing
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (i % 3) ? (char) 0xFF : (char) YAHDLC_FLAG_SEQUENCE;
+  }
+  send_data[10] = (char) rand();
+
+  // Create frames back to back, where each frame is not a whole number of
+  // bytes (the lookup tables are built by the first encoder init)
+  yahdlc_bit_encoder_init(&encoder);
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i < 4; i++) {
+    control.seq_no = i;
+    ret = yahdlc_bit_frame_data(&encoder, &control, send_data, sizeof(send_data),
+                                &stream[stream_length], &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    BOOST_CHECK(frame_length > sizeof(send_data));
+    stream_length += frame_length;
+  }
+  stream_length += yahdlc_bit_flush(&encoder, &stream[stream_length]);
+
+  // Decode the stream at every bit offset in chunks of different sizes
+  for (shift = 0; shift < 8; shift++) {
+    for (i = 0; i <= stream_length; i++) {
+      unsigned int bits = (i ? (unsigned char) stream[i - 1] : 0xFF)
+          | ((i < stream_length ? (unsigned char) stream[i] : 0xFF) << 8);
+      shifted[i] = (bits << shift) >> 8;
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.expected = send_data;
+    result.expected_len = sizeof(send_data);
+    yahdlc_bit_decoder_init(&decoder, buffer, sizeof(buffer));
+    for (i = 0, j = 1; i <= stream_length; i += j, j = (j % 7) + 1) {
+      ret = yahdlc_bit_get_data(&decoder, &shifted[i],
+                                (i + j > stream_length + 1) ? (stream_length + 1 - i) : j,
+                                bit_frame, &result);
+      BOOST_CHECK(ret >= 0);
+    }
+    BOOST_CHECK_EQUAL(result.frames, 4);
+    BOOST_CHECK_EQUAL(result.errors, 0);
+  }
+
+  // Corrupt a bit within the first frame
+  stream[8] ^= 0x10;
+  memset(&result, 0, sizeof(result));
+  result.frames = 1;
+  result.expected = send_data;
+  result.expected_len = sizeof(send_data);
+  yahdlc_bit_decoder_init(&decoder, buffer, sizeof(buffer));
+  ret = yahdlc_bit_get_data(&decoder, stream, stream_length, bit_frame, &result);
+  BOOST_CHECK_EQUAL(ret, 3);
+  BOOST_CHECK_EQUAL(result.errors, 1);
+
+  // Seven consecutive ones abort the frame without reporting it
+  stream[8] = (char) 0xFF;
+  stream[9] = (char) 0xFF;
+  memset(&result, 0, sizeof(result));
+  result.frames = 1;
+  result.expected = send_data;
+  result.expected_len = sizeof(send_data);
+  yahdlc_bit_decoder_init(&decoder, buffer, sizeof(buffer));
+  ret = yahdlc_bit_get_data(&decoder, stream, stream_length, bit_frame, &result);
+  BOOST_CHECK_EQUAL(ret, 3);
+  BOOST_CHECK_EQUAL(result.errors, 0);
+
+  // Frames larger than the buffer are dropped
+  yahdlc_bit_encoder_init(&encoder);
+  yahdlc_bit_frame_data(&encoder, &control, send_data, sizeof(send_data),
+                        stream, &frame_length);
+  frame_length += yahdlc_bit_flush(&encoder, &stream[frame_length]);
+  yahdlc_bit_decoder_init(&decoder, buffer, 16);
+  ret = yahdlc_bit_get_data(&decoder, stream, frame_length, bit_frame, &result);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(result.errors, 1);
+
+  ret = yahdlc_bit_decoder_init(&decoder, NULL, 0);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestSharedMemoryRing) {
+  int ret;
+  yahdlc_shm_t shm, subscriber;
+  yahdlc_shm_reader_t readers[2];
+  yahdlc_control_t control, recv_control;
+  unsigned char address;
+  char send_data[100], recv_data[100];
+  unsigned int i, j, recv_length = 0;
+  static unsigned long long memory[(YAHDLC_SHM_HEADER_SIZE + 1024) / 8];
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) i;
+  }
+
+  ret = yahdlc_shm_init(memory, YAHDLC_SHM_HEADER_SIZE);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_shm_init(memory, sizeof(memory));
+  BOOST_CHECK_EQUAL(ret, 0);
+  for (i = 0; i < 2; i++) {
+    ret = yahdlc_shm_reader_init(&readers[i], memory, sizeof(memory));
+    BOOST_CHECK_EQUAL(ret, 0);
+  }
+
+  // Both subscribers receive every frame, also when the ring wraps
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i < 30; i++) {
+    control.seq_no = i;
+    ret = yahdlc_shm_publish(memory, i, &control, send_data, 1 + (i * 7) % sizeof(send_data));
+    BOOST_CHECK_EQUAL(ret, 0);
+
+    for (j = 0; j < 2; j++) {
+      ret = yahdlc_shm_read(&readers[j], &address, &recv_control, recv_data,
+                            sizeof(recv_data), &recv_length);
+      BOOST_CHECK_EQUAL(ret, 0);
+      BOOST_CHECK_EQUAL(address, i);
+      BOOST_CHECK_EQUAL(recv_control.frame, YAHDLC_FRAME_DATA);
+      BOOST_CHECK_EQUAL(recv_control.seq_no, i % 8);
+      BOOST_CHECK_EQUAL(recv_length, 1 + (i * 7) % sizeof(send_data));
+      BOOST_CHECK_EQUAL(memcmp(recv_data, send_data, recv_length), 0);
+
+      ret = yahdlc_shm_read(&readers[j], &address, &recv_control, recv_data,
+                            sizeof(recv_data), &recv_length);
+      BOOST_CHECK_EQUAL(ret, -EAGAIN);
+    }
+  }
+
+  // A subscriber falling behind by more than the capacity detects the overrun
+  // and continues with the next published frame, without affecting the other
+  for (i = 0; i < 20; i++) {
+    ret = yahdlc_shm_publish(memory, 1, &control, send_data, sizeof(send_data));
+    BOOST_CHECK_EQUAL(ret, 0);
+    ret = yahdlc_shm_read(&readers[1], &address, &recv_control, recv_data,
+                          sizeof(recv_data), &recv_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+  }
+  ret = yahdlc_shm_read(&readers[0], &address, &recv_control, recv_data,
+                        sizeof(recv_data), &recv_length);
+  BOOST_CHECK_EQUAL(ret, -EOVERFLOW);
+  BOOST_CHECK_EQUAL(readers[0].overruns, 1);
+  ret = yahdlc_shm_publish(memory, 2, &control, send_data, 10);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_shm_read(&readers[0], &address, &recv_control, recv_data,
+                        sizeof(recv_data), &recv_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(address, 2);
+
+  // Frames larger than the destination buffer are skipped
+  yahdlc_shm_publish(memory, 3, &control, send_data, sizeof(send_data));
+  ret = yahdlc_shm_read(&readers[0], &address, &recv_control, recv_data, 10,
+                        &recv_length);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+  ret = yahdlc_shm_read(&readers[0], &address, &recv_control, recv_data, 10,
+                        &recv_length);
+  BOOST_CHECK_EQUAL(ret, -EAGAIN);
+
+  ret = yahdlc_shm_publish(memory, 3, &control, send_data, 1024);
+  BOOST_CHECK_EQUAL(ret, -EMSGSIZE);
+
+  // A ring whose capacity does not fit the memory is rejected
+  ret = yahdlc_shm_reader_init(&readers[0], memory, YAHDLC_SHM_HEADER_SIZE + 512);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ((unsigned int *) memory)[1] = 1000;
+  ret = yahdlc_shm_reader_init(&readers[0], memory, sizeof(memory));
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  // Publish through a POSIX shared memory object mapped twice
+  ret = yahdlc_shm_create(&shm, "/yahdlc_test", 4096);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_shm_attach(&subscriber, "/yahdlc_test");
+  BOOST_CHECK_EQUAL(ret, 0);
+  if ((shm.memory) && (subscriber.memory)) {
+    ret = yahdlc_shm_reader_init(&readers[0], subscriber.memory, subscriber.size);
+    BOOST_CHECK_EQUAL(ret, 0);
+    yahdlc_shm_publish(shm.memory, 4, &control, send_data, sizeof(send_data));
+    ret = yahdlc_shm_read(&readers[0], &address, &recv_control, recv_data,
+                          sizeof(recv_data), &recv_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    BOOST_CHECK_EQUAL(address, 4);
+    BOOST_CHECK_EQUAL(memcmp(recv_data, send_data, sizeof(send_data)), 0);
+  }
+  yahdlc_shm_close(&subscriber);
+  yahdlc_shm_close(&shm);
+  BOOST_CHECK_EQUAL(yahdlc_shm_unlink("/yahdlc_test"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestStreamingEncoder) {
+  int ret;
+  yahdlc_encoder_t encoder;
+  yahdlc_control_t control;
+  char send_data[300], frame_data[700], stream_data[700];
+  unsigned int i, len, frame_length = 0, stream_length = 0;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+  send_data[7] = YAHDLC_FLAG_SEQUENCE;
+  send_data[8] = YAHDLC_CONTROL_ESCAPE;
+
+  // Data added in chunks of different sizes must give the same frame
+  control.frame = YAHDLC_FRAME_DATA;
+  control.seq_no = 3;
+  ret = yahdlc_frame_begin(&encoder, 0x7D, &control, stream_data, &len);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK(len <= YAHDLC_FRAME_BEGIN_SIZE_MAX);
+  stream_length = len;
+  for (i = 0; i < sizeof(send_data); i += len) {
+    len = std::min((unsigned int) sizeof(send_data) - i, 1 + (i % 37));
+    ret = yahdlc_frame_append(&encoder, &send_data[i], len,
+                              &stream_data[stream_length], &frame_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    stream_length += frame_length;
+  }
+  ret = yahdlc_frame_finish(&encoder, &stream_data[stream_length], &len);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK(len <= YAHDLC_FRAME_FINISH_SIZE_MAX);
+  stream_length += len;
+
+  yahdlc_frame_data_with_address(0x7D, &control, send_data, sizeof(send_data),
+                                 frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(stream_length, frame_length);
+  BOOST_CHECK_EQUAL(memcmp(stream_data, frame_data, frame_length), 0);
+
+  // Data is ignored for other than DATA frames
+  control.frame = YAHDLC_FRAME_ACK;
+  yahdlc_frame_begin(&encoder, YAHDLC_ALL_STATION_ADDR, &control, stream_data, &len);
+  ret = yahdlc_frame_append(&encoder, send_data, sizeof(send_data),
+                            stream_data, &len);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(len, 0);
+
+  ret = yahdlc_frame_append(&encoder, NULL, 1, stream_data, &len);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_frame_finish(NULL, stream_data, &len);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestRingEncoder) {
+  int ret;
+  yahdlc_control_t control;
+  char send_data[40], frame_data[100], ring[128], unwrapped[128], saved[128];
+  unsigned int i, frame_length = 0, head = 100, tail = 90;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (i % 5) ? (char) i : (char) YAHDLC_FLAG_SEQUENCE;
+  }
+
+  // The frame wraps around the end of the ring
+  control.frame = YAHDLC_FRAME_DATA;
+  control.seq_no = 2;
+  yahdlc_frame_data(&control, send_data, sizeof(send_data), frame_data,
+                    &frame_length);
+  memset(ring, 0, sizeof(ring));
+  ret = yahdlc_frame_data_ring(&control, send_data, sizeof(send_data), ring,
+                               sizeof(ring), head, tail);
+  BOOST_CHECK_EQUAL(ret, (head + frame_length) % sizeof(ring));
+  for (i = 0; i < frame_length; i++) {
+    unwrapped[i] = ring[(head + i) % sizeof(ring)];
+  }
+  BOOST_CHECK_EQUAL(memcmp(unwrapped, frame_data, frame_length), 0);
+
+  // Nothing is written when the frame does not fit (even if only the escaped
+  // values do not fit), and exactly fitting frames are written
+  head = ret;
+  tail = (head + frame_length) % sizeof(ring);
+  memcpy(saved, ring, sizeof(ring));
+  ret = yahdlc_frame_data_ring(&control, send_data, sizeof(send_data), ring,
+                               sizeof(ring), head, tail);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+  BOOST_CHECK_EQUAL(memcmp(saved, ring, sizeof(ring)), 0);
+
+  tail = (head + frame_length + 1) % sizeof(ring);
+  ret = yahdlc_frame_data_ring(&control, send_data, sizeof(send_data), ring,
+                               sizeof(ring), head, tail);
+  BOOST_CHECK_EQUAL(ret, (head + frame_length) % sizeof(ring));
+
+  ret = yahdlc_frame_data_ring(&control, send_data, sizeof(send_data), ring,
+                               sizeof(ring), sizeof(ring), 0);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  // Data sizes overflowing the frame size calculation are never written
+  memcpy(saved, ring, sizeof(ring));
+  ret = yahdlc_frame_data_ring(&control, send_data, UINT_MAX - 1, ring,
+                               sizeof(ring), 0, 0);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+  BOOST_CHECK_EQUAL(memcmp(saved, ring, sizeof(ring)), 0);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestRetransmissionCache) {
+  int ret;
+  yahdlc_cache_t cache;
+  yahdlc_control_t control;
+  const char *frame, *cached;
+  char send_data[32], frame_data[YAHDLC_CACHE_SLOT_SIZE(32)];
+  char buffers[YAHDLC_CACHE_SLOTS][YAHDLC_CACHE_SLOT_SIZE(32)];
+  unsigned int i, frame_length = 0, cached_length = 0;
+
+  for (i = 0; i < sizeof(send_data); i++) {
+    send_data[i] = (char) rand();
+  }
+
+  ret = yahdlc_cache_init(&cache, &buffers[0][0], sizeof(buffers[0]));
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // Frames are kept per sequence number and are identical to
+  // yahdlc_frame_data, but at most one less than the sequence numbers
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i < YAHDLC_CACHE_SLOTS; i++) {
+    control.seq_no = i;
+    ret = yahdlc_cache_frame_data(&cache, &control, send_data, i + 1, &frame,
+                                  &frame_length);
+    BOOST_CHECK_EQUAL(ret, (i < YAHDLC_CACHE_WINDOW_MAX) ? 0 : -EBUSY);
+  }
+
+  for (i = 0; i < YAHDLC_CACHE_WINDOW_MAX; i++) {
+    control.seq_no = i;
+    yahdlc_frame_data(&control, send_data, i + 1, frame_data, &frame_length);
+    ret = yahdlc_cache_get(&cache, i, &cached, &cached_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    BOOST_CHECK_EQUAL(cached_length, frame_length);
+    BOOST_CHECK_EQUAL(memcmp(cached, frame_data, frame_length), 0);
+  }
+
+  // Released slots are empty until the sequence number is used again
+  yahdlc_cache_release(&cache, 3);
+  ret = yahdlc_cache_get(&cache, 3, &cached, &cached_length);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  control.seq_no = YAHDLC_CACHE_WINDOW_MAX;
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, 1, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // A smaller window only blocks new frames
+  ret = yahdlc_cache_set_window(&cache, 2);
+  BOOST_CHECK_EQUAL(ret, 0);
+  control.seq_no = 3;
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, 1, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, -EBUSY);
+  control.seq_no = 0;
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, 1, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_cache_set_window(&cache, 0);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  ret = yahdlc_cache_set_window(&cache, YAHDLC_CACHE_WINDOW_MAX + 1);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+
+  // Acknowledge frames are encoded once for every sequence number
+  for (i = 0; i < YAHDLC_CACHE_SLOTS; i++) {
+    control.frame = (i % 2) ? YAHDLC_FRAME_ACK : YAHDLC_FRAME_NACK;
+    control.seq_no = i;
+    yahdlc_frame_data(&control, NULL, 0, frame_data, &frame_length);
+    ret = yahdlc_cache_s_frame(&cache, &control, &cached, &cached_length);
+    BOOST_CHECK_EQUAL(ret, 0);
+    BOOST_CHECK_EQUAL(cached_length, frame_length);
+    BOOST_CHECK_EQUAL(memcmp(cached, frame_data, frame_length), 0);
+  }
+
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, 1, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, -EINVAL);
+  control.frame = YAHDLC_FRAME_DATA;
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, 33, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+  ret = yahdlc_cache_frame_data(&cache, &control, send_data, UINT_MAX - 4,
+                                &frame, &frame_length);
+  BOOST_CHECK_EQUAL(ret, -ENOBUFS);
+}
+
+BOOST_AUTO_TEST_CASE(yahdlcTestXidNegotiation) {
+  int ret;
+  yahdlc_control_t control;
+  yahdlc_fragment_tx_t tx;
+  yahdlc_fragment_rx_t rx;
+  yahdlc_cache_t cache;
+  yahdlc_xid_params_t local = { 512, 7, YAHDLC_XID_FCS_BITS, 1 };
+  yahdlc_xid_params_t remote = { 256, 4, YAHDLC_XID_FCS_BITS, 1 };
+  yahdlc_xid_params_t received, result;
+  const char *frame;
+  char frame_data[64], recv_data[64], *msg;
+  static char buffers[YAHDLC_FRAGMENT_MAX_MESSAGES][1024];
+  char slots[YAHDLC_CACHE_SLOTS][YAHDLC_CACHE_SLOT_SIZE(16)];
+  unsigned int i, frame_length = 0, recv_length = 0, msg_len;
+
+  // The XID control field is kept apart from the acknowledge frames
+  control.frame = YAHDLC_FRAME_XID;
+  control.seq_no = 0;
+  BOOST_CHECK_EQUAL(yahdlc_frame_control_type(&control), 0xBF);
+  BOOST_CHECK_EQUAL(yahdlc_get_control_type(0xBF).frame, YAHDLC_FRAME_XID);
+  BOOST_CHECK_EQUAL(yahdlc_get_control_type(0xAF).frame, YAHDLC_FRAME_XID);
+
+  // The peer sends its parameters in a XID frame at link bring-up
+  yahdlc_get_data_reset();
+  ret = yahdlc_xid_frame_data(&remote, frame_data, &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+  ret = yahdlc_get_data(&control, frame_data, frame_length, recv_data,
+                        &recv_length);
+  BOOST_CHECK_EQUAL(ret, (int )(frame_length - 1));
+  BOOST_CHECK_EQUAL(control.frame, YAHDLC_FRAME_XID);
+  BOOST_CHECK_EQUAL(recv_length, YAHDLC_XID_INFO_SIZE);
+
+  ret = yahdlc_xid_decode(recv_data, recv_length, &received);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(received.max_info, remote.max_info);
+  BOOST_CHECK_EQUAL(received.window, remote.window);
+  BOOST_CHECK_EQUAL(received.fcs_bits, remote.fcs_bits);
+  BOOST_CHECK_EQUAL(received.cobs, 1);
+
+  // Both stations use the smaller frame size and window
+  ret = yahdlc_xid_negotiate(&local, &received, &result);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(result.max_info, 256);
+  BOOST_CHECK_EQUAL(result.window, 4);
+  BOOST_CHECK_EQUAL(result.cobs, 1);
+
+  // The link starts with the conservative frame size and uses larger frames
+  // after the negotiation, which drops incomplete received messages
+  yahdlc_fragment_tx_init(&tx, YAHDLC_XID_FRAGMENT_SIZE_DEFAULT);
+  yahdlc_fragment_rx_init(&rx, YAHDLC_XID_FRAGMENT_SIZE_DEFAULT, 10,
+                          &buffers[0][0], sizeof(buffers[0]));
+  yahdlc_cache_init(&cache, &slots[0][0], sizeof(slots[0]));
+  memset(recv_data, 0, sizeof(recv_data));
+  recv_data[1] = 1;
+  recv_data[2] = (char) (YAHDLC_FRAGMENT_LAST >> 8);
+  ret = yahdlc_fragment_receive(&rx, recv_data, YAHDLC_FRAGMENT_HEADER_SIZE + 10,
+                                0, &msg, &msg_len);
+  BOOST_CHECK_EQUAL(ret, -EAGAIN);
+
+  ret = yahdlc_xid_apply(&result, &tx, &rx, &cache);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK(tx.fragment_size > YAHDLC_XID_FRAGMENT_SIZE_DEFAULT);
+  BOOST_CHECK_EQUAL(tx.fragment_size, 256 - YAHDLC_FRAGMENT_HEADER_SIZE);
+  BOOST_CHECK_EQUAL(rx.fragment_size, 256 - YAHDLC_FRAGMENT_HEADER_SIZE);
+  BOOST_CHECK_EQUAL(yahdlc_fragment_expire(&rx, 1000), 0);
+
+  // The cache keeps at most the negotiated window of frames
+  control.frame = YAHDLC_FRAME_DATA;
+  for (i = 0; i <= result.window; i++) {
+    control.seq_no = i;
+    ret = yahdlc_cache_frame_data(&cache, &control, recv_data, 16, &frame,
+                                  &frame_length);
+    BOOST_CHECK_EQUAL(ret, (i < result.window) ? 0 : -EBUSY);
+  }
+  yahdlc_cache_release(&cache, 0);
+  ret = yahdlc_cache_frame_data(&cache, &control, recv_data, 16, &frame,
+                                &frame_length);
+  BOOST_CHECK_EQUAL(ret, 0);
+
+  // The frame size is limited to what this build supports
+  local.max_info = remote.max_info = 0xFFFF;
+  ret = yahdlc_xid_negotiate(&local, &remote, &result);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(result.max_info, YAHDLC_XID_MAX_INFO_MAX);
+  ret = yahdlc_xid_apply(&result, &tx, NULL, NULL);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(tx.fragment_size, YAHDLC_FRAGMENT_SIZE_MAX);
+
+  // Missing parameters fall back to the defaults and unknown ones are skipped
+  const char defaults[] = { (char) 0x82, (char) 0x80, 0, 3, 0x7F, 1, 0x55 };
+  ret = yahdlc_xid_decode(defaults, sizeof(defaults), &received);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(received.max_info, YAHDLC_XID_MAX_INFO_DEFAULT);
+  BOOST_CHECK_EQUAL(received.window, 1);
+  BOOST_CHECK_EQUAL(received.fcs_bits, YAHDLC_XID_FCS_BITS);
+  BOOST_CHECK_EQUAL(received.cobs, 0);
+
+  // COBS frames are only used if both stations support them
+  ret = yahdlc_xid_negotiate(&local, &received, &result);
+  BOOST_CHECK_EQUAL(ret, 0);
+  BOOST_CHECK_EQUAL(result.cobs, 0);
+
+  // A different FCS can not be used with this build
+  received.fcs_bits = (YAHDLC_XID_FCS_BITS == 16) ? 32 : 16;
+  ret = yahdlc_xid_negotiate(&local, &received, &result);
+  BOOST_CHECK_EQUAL(ret, -ENOTSUP);
+
+  // Truncated parameters and invalid windows are rejected
+  const char truncated[] = { (char) 0x82, (char) 0x80, 0, 4, 0x06, 2, 0x01 };
+  ret = yahdlc_xid_decode(truncated, sizeof(truncated), &received);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  const char window[] = { (char) 0x82, (char) 0x80, 0, 3, 0x08, 1, 8 };
+  ret = yahdlc_xid_decode(window, sizeof(window), &received);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+  ret = yahdlc_xid_decode(frame_data, 2, &received);
+  BOOST_CHECK_EQUAL(ret, -ENOMSG);
+}
@@ -0,0 +1,539 @@
+/**
+ * @file yahdlc_gen.c
+ *
+ * Generates (or replays) HDLC traffic at a target rate for load testing
+ */
+
+#define _GNU_SOURCE
+#include "yahdlc.h"
+#include "yahdlc_capture.h"
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Largest supported payload size
+#define YAHDLC_GEN_MAX_PAYLOAD 65536
+
+// Worst case frame size (all bytes escaped)
+#define YAHDLC_GEN_MAX_FRAME ((2 * (YAHDLC_GEN_MAX_PAYLOAD + 2 + sizeof(FCS_SIZE))) + 2)
+
+typedef struct {
+  unsigned int min;
+  unsigned int max;
+} yahdlc_gen_range_t;
+
+typedef struct {
+  unsigned long long frames;
+  yahdlc_gen_range_t size;
+  yahdlc_gen_range_t chunk;
+  unsigned int escape_percent;
+  unsigned int ack_percent;
+  unsigned int nack_percent;
+  unsigned int errors_per_million;
+  unsigned long long rate;
+  const char *output;
+  const char *replay;
+  int pty;
+  int decode;
+} yahdlc_gen_options_t;
+
+// Destination of the generated traffic. With a chunk size range the frames
+// are collected in the chunk buffer, so chunks can span frame boundaries.
+typedef struct {
+  int fd;
+  char *dest;
+  double start;
+  char *chunk;
+  unsigned int chunk_length;
+  unsigned int chunk_size;
+} yahdlc_gen_output_t;
+
+typedef struct {
+  unsigned long long frames;
+  unsigned long long bytes;
+  unsigned long long errors;
+  unsigned long long decoded;
+  unsigned long long decode_errors;
+} yahdlc_gen_stats_t;
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -n FRAMES      Number of frames to generate (0 = unlimited, default 1000)\n"
+          "  -s MIN[-MAX]   Payload size range in bytes (default 64)\n"
+          "  -e PERCENT     Percentage of payload bytes to be escaped (default 0)\n"
+          "  -a PERCENT     Percentage of ACK frames (default 0)\n"
+          "  -k PERCENT     Percentage of NACK frames (default 0)\n"
+          "  -x ERRORS      Bit errors injected per million bytes (default 0)\n"
+          "  -c MIN[-MAX]   Size range of the written chunks, which can span frames\n"
+          "                 (default whole frames)\n"
+          "  -r RATE        Target rate in bytes per second (default unlimited)\n"
+          "  -o PATH        Output file or pipe (default stdout)\n"
+          "  -p             Create a pseudo terminal and write to it\n"
+          "  -R CAPTURE     Replay the frames of a capture file\n"
+          "  -d             Decode the traffic in-process instead of writing it\n"
+          "  -S SEED        Seed for the random generator\n", name);
+}
+
+static int parse_range(const char *arg, yahdlc_gen_range_t *range) {
+  char *end;
+
+  if ((*arg < '0') || (*arg > '9')) {
+    return -EINVAL;
+  }
+
+  range->min = range->max = strtoul(arg, &end, 0);
+  if ((*end == '-') && (end[1] >= '0') && (end[1] <= '9')) {
+    range->max = strtoul(end + 1, &end, 0);
+  }
+
+  return (*end || (range->min > range->max)) ? -EINVAL : 0;
+}
+
+static int parse_value(const char *arg, unsigned long max, unsigned int *value) {
+  char *end;
+  unsigned long result;
+
+  if ((*arg < '0') || (*arg > '9')) {
+    return -EINVAL;
+  }
+
+  result = strtoul(arg, &end, 0);
+  if (*end || (result > max)) {
+    return -EINVAL;
+  }
+
+  *value = result;
+  return 0;
+}
+
+static int parse_count(const char *arg, unsigned long long *value) {
+  char *end;
+
+  if ((*arg < '0') || (*arg > '9')) {
+    return -EINVAL;
+  }
+
+  *value = strtoull(arg, &end, 0);
+  return *end ? -EINVAL : 0;
+}
+
+static unsigned int random_range(const yahdlc_gen_range_t *range) {
+  return range->min + (rand() % (range->max - range->min + 1));
+}
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static int open_pty(void) {
+  int fd, slave;
+  const char *name;
+  struct termios tio;
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if ((fd < 0) || grantpt(fd) || unlockpt(fd) || !(name = ptsname(fd))) {
+    return -1;
+  }
+
+  // Keep the slave open in raw mode so the data is buffered until a reader
+  // opens it and no line discipline processing is done on the frames
+  slave = open(name, O_RDWR | O_NOCTTY);
+  if ((slave < 0) || tcgetattr(slave, &tio)) {
+    return -1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+
+  fprintf(stderr, "Writing to %s\n", name);
+  return fd;
+}
+
+static void generate_payload(const yahdlc_gen_options_t *options, char *payload,
+                             unsigned int length) {
+  unsigned int i;
+
+  for (i = 0; i < length; i++) {
+    if ((unsigned int) (rand() % 100) < options->escape_percent) {
+      payload[i] = (rand() % 2) ? YAHDLC_FLAG_SEQUENCE : YAHDLC_CONTROL_ESCAPE;
+    } else {
+      // Values up to 0x70 are never escaped
+      payload[i] = (char) (rand() % 0x70);
+    }
+  }
+}
+
+static yahdlc_frame_t generate_frame_type(const yahdlc_gen_options_t *options) {
+  unsigned int value = rand() % 100;
+
+  if (value < options->ack_percent) {
+    return YAHDLC_FRAME_ACK;
+  } else if (value < (options->ack_percent + options->nack_percent)) {
+    return YAHDLC_FRAME_NACK;
+  }
+
+  return YAHDLC_FRAME_DATA;
+}
+
+static unsigned int inject_errors(const yahdlc_gen_options_t *options,
+                                  char *frame, unsigned int length) {
+  unsigned int i, errors = 0;
+
+  if (!options->errors_per_million) {
+    return 0;
+  }
+
+  for (i = 0; i < length; i++) {
+    if ((unsigned int) (rand() % 1000000) < options->errors_per_million) {
+      frame[i] ^= 1 << (rand() % 8);
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+static void throttle(const yahdlc_gen_options_t *options, double start,
+                     unsigned long long bytes) {
+  double delay;
+  struct timespec ts;
+
+  if (!options->rate) {
+    return;
+  }
+
+  delay = ((double) bytes / options->rate) - (now() - start);
+  if (delay > 0) {
+    ts.tv_sec = (time_t) delay;
+    ts.tv_nsec = (long) ((delay - ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+  }
+}
+
+static int write_all(int fd, const char *data, unsigned int length) {
+  ssize_t ret;
+
+  while (length) {
+    ret = write(fd, data, length);
+    if (ret < 0) {
+      return -1;
+    }
+    data += ret;
+    length -= ret;
+  }
+
+  return 0;
+}
+
+// Decodes the chunk the same way as done when receiving from a UART
+static void decode_chunk(yahdlc_gen_stats_t *stats, const char *chunk,
+                         unsigned int length, char *dest) {
+  int ret;
+  unsigned int dest_len;
+  yahdlc_control_t control;
+
+  while (length) {
+    ret = yahdlc_get_data(&control, chunk, length, dest, &dest_len);
+    if (ret >= 0) {
+      stats->decoded++;
+    } else if (ret == -EIO) {
+      stats->decode_errors++;
+      ret = dest_len;
+    } else {
+      break;
+    }
+
+    chunk += ret;
+    length -= ret;
+  }
+}
+
+static int write_chunk(const yahdlc_gen_options_t *options,
+                       yahdlc_gen_stats_t *stats,
+                       const yahdlc_gen_output_t *output, const char *chunk,
+                       unsigned int length) {
+  if (options->decode) {
+    decode_chunk(stats, chunk, length, output->dest);
+  } else {
+    throttle(options, output->start, stats->bytes);
+    if (write_all(output->fd, chunk, length)) {
+      perror("write");
+      return -1;
+    }
+  }
+  stats->bytes += length;
+
+  return 0;
+}
+
+static void next_chunk_size(const yahdlc_gen_options_t *options,
+                            yahdlc_gen_output_t *output) {
+  output->chunk_length = 0;
+  output->chunk_size = random_range(&options->chunk);
+  if (!output->chunk_size) {
+    output->chunk_size = 1;
+  }
+}
+
+static int output_frame(const yahdlc_gen_options_t *options,
+                        yahdlc_gen_stats_t *stats, yahdlc_gen_output_t *output,
+                        char *frame, unsigned int length) {
+  unsigned int offset, chunk;
+
+  stats->frames++;
+  stats->errors += inject_errors(options, frame, length);
+
+  if (!options->chunk.max) {
+    return write_chunk(options, stats, output, frame, length);
+  }
+
+  // Fill the current chunk and write it once it reached its random size
+  for (offset = 0; offset < length; offset += chunk) {
+    chunk = output->chunk_size - output->chunk_length;
+    if (chunk > (length - offset)) {
+      chunk = length - offset;
+    }
+
+    memcpy(&output->chunk[output->chunk_length], &frame[offset], chunk);
+    output->chunk_length += chunk;
+
+    if (output->chunk_length == output->chunk_size) {
+      if (write_chunk(options, stats, output, output->chunk,
+                      output->chunk_length)) {
+        return -1;
+      }
+      next_chunk_size(options, output);
+    }
+  }
+
+  return 0;
+}
+
+// Writes the last chunk, which can be smaller than its random size
+static int flush_chunk(const yahdlc_gen_options_t *options,
+                       yahdlc_gen_stats_t *stats, yahdlc_gen_output_t *output) {
+  int ret = 0;
+
+  if (output->chunk_length) {
+    ret = write_chunk(options, stats, output, output->chunk,
+                      output->chunk_length);
+    output->chunk_length = 0;
+  }
+
+  return ret;
+}
+
+static int generate(const yahdlc_gen_options_t *options,
+                    yahdlc_gen_stats_t *stats, yahdlc_gen_output_t *output,
+                    char *payload, char *frame) {
+  unsigned int length, frame_length;
+  yahdlc_control_t control;
+
+  while (!options->frames || (stats->frames < options->frames)) {
+    length = random_range(&options->size);
+    generate_payload(options, payload, length);
+
+    control.frame = generate_frame_type(options);
+    control.seq_no = stats->frames;
+    yahdlc_frame_data(&control, payload, length, frame, &frame_length);
+
+    if (output_frame(options, stats, output, frame, frame_length)) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int replay(const yahdlc_gen_options_t *options,
+                  yahdlc_gen_stats_t *stats, yahdlc_gen_output_t *output,
+                  char *frame) {
+  size_t i;
+  int ret = 0;
+  unsigned int frame_length;
+  yahdlc_control_t control;
+  yahdlc_capture_reader_t reader;
+  yahdlc_capture_record_t record;
+
+  if (yahdlc_capture_reader_open(&reader, options->replay)) {
+    fprintf(stderr, "Unable to open capture %s\n", options->replay);
+    return -1;
+  }
+
+  for (i = 0; !ret && (i < reader.frames); i++) {
+    if (yahdlc_capture_read(&reader, i, &record)
+        || (record.length > YAHDLC_GEN_MAX_PAYLOAD)) {
+      fprintf(stderr, "Invalid frame %zu in capture\n", i);
+      ret = -1;
+      break;
+    }
+
+    control = record.control;
+    yahdlc_frame_data_with_address(record.address, &control, record.data,
+                                   record.length, frame, &frame_length);
+    ret = output_frame(options, stats, output, frame, frame_length);
+  }
+
+  yahdlc_capture_reader_close(&reader);
+  return ret;
+}
+
+int main(int argc, char *argv[]) {
+  int opt, ret;
+  unsigned int seed;
+  double elapsed;
+  char *payload, *frame;
+  yahdlc_gen_stats_t stats;
+  yahdlc_gen_options_t options;
+  yahdlc_gen_output_t output;
+
+  memset(&stats, 0, sizeof(stats));
+  memset(&options, 0, sizeof(options));
+  memset(&output, 0, sizeof(output));
+  output.fd = STDOUT_FILENO;
+  options.frames = 1000;
+  options.size.min = options.size.max = 64;
+
+  while ((opt = getopt(argc, argv, "n:s:e:a:k:x:c:r:o:pR:dS:h")) != -1) {
+    switch (opt) {
+      case 'n':
+        if (parse_count(optarg, &options.frames)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 's':
+        if (parse_range(optarg, &options.size)
+            || (options.size.max > YAHDLC_GEN_MAX_PAYLOAD)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'e':
+        if (parse_value(optarg, 100, &options.escape_percent)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'a':
+        if (parse_value(optarg, 100, &options.ack_percent)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'k':
+        if (parse_value(optarg, 100, &options.nack_percent)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'x':
+        if (parse_value(optarg, 1000000, &options.errors_per_million)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'c':
+        if (parse_range(optarg, &options.chunk)
+            || (options.chunk.max > YAHDLC_GEN_MAX_FRAME)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'r':
+        if (parse_count(optarg, &options.rate)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'o':
+        options.output = optarg;
+        break;
+      case 'p':
+        options.pty = 1;
+        break;
+      case 'R':
+        options.replay = optarg;
+        break;
+      case 'd':
+        options.decode = 1;
+        break;
+      case 'S':
+        if (parse_value(optarg, UINT_MAX, &seed)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        srand(seed);
+        break;
+      default:
+        usage(argv[0]);
+        return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  // The ACK and NACK frames are a share of all generated frames
+  if ((options.ack_percent + options.nack_percent) > 100) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (options.pty) {
+    output.fd = open_pty();
+  } else if (options.output && strcmp(options.output, "-")) {
+    output.fd = open(options.output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  if (output.fd < 0) {
+    perror("open");
+    return EXIT_FAILURE;
+  }
+
+  payload = malloc(YAHDLC_GEN_MAX_PAYLOAD);
+  frame = malloc(YAHDLC_GEN_MAX_FRAME);
+  output.dest = malloc(YAHDLC_GEN_MAX_FRAME);
+  output.chunk = malloc(options.chunk.max ? options.chunk.max : 1);
+  if (!payload || !frame || !output.dest || !output.chunk) {
+    perror("malloc");
+    return EXIT_FAILURE;
+  }
+
+  if (options.chunk.max) {
+    next_chunk_size(&options, &output);
+  }
+
+  output.start = now();
+  if (options.replay) {
+    ret = replay(&options, &stats, &output, frame);
+  } else {
+    ret = generate(&options, &stats, &output, payload, frame);
+  }
+  if (!ret) {
+    ret = flush_chunk(&options, &stats, &output);
+  }
+  elapsed = now() - output.start;
+
+  fprintf(stderr, "%llu frames, %llu bytes, %llu bit errors in %.3f s (%.1f MB/s)\n",
+          stats.frames, stats.bytes, stats.errors, elapsed,
+          (elapsed > 0) ? (stats.bytes / elapsed / 1e6) : 0);
+  if (options.decode) {
+    fprintf(stderr, "%llu frames decoded, %llu FCS errors\n", stats.decoded,
+            stats.decode_errors);
+  }
+
+  free(payload);
+  free(frame);
+  free(output.dest);
+  free(output.chunk);
+  close(output.fd);
+
+  return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -13,13 +13,20 @@
 #define YAHDLC_CONTROL_TYPE_REJECT 2
 #define YAHDLC_CONTROL_TYPE_SELECTIVE_REJECT 3
 
+// HDLC Exchange Identification (XID) U-frame control value without Poll/Final bit
+#define YAHDLC_CONTROL_U_FRAME_XID 0xAF
+
 static yahdlc_state_t yahdlc_state = {
   .control_escape = 0,
+  .address = YAHDLC_ALL_STATION_ADDR,
   .fcs = FCS_INIT_VALUE,
   .start_index = -1,
   .end_index = -1,
   .src_index = 0,
   .dest_index = 0,
+  .value_index = 0,
+  .cobs_code = 0,
+  .cobs_left = 0,
 };
 
 int yahdlc_set_state(yahdlc_state_t *state) {
@@ -55,8 +62,12 @@ void yahdlc_escape_value(char value, char *dest, int *dest_index) {
 yahdlc_control_t yahdlc_get_control_type(unsigned char control) {
   yahdlc_control_t value;
 
-  // Check if the frame is a S-frame (or U-frame)
-  if (control & (1 << YAHDLC_CONTROL_S_OR_U_FRAME_BIT)) {
+  // Check if the frame is a XID U-frame (with or without Poll/Final bit)
+  if ((control & ~(1 << YAHDLC_CONTROL_POLL_BIT)) == YAHDLC_CONTROL_U_FRAME_XID) {
+    value.frame = YAHDLC_FRAME_XID;
+    value.seq_no = 0;
+  } else if (control & (1 << YAHDLC_CONTROL_S_OR_U_FRAME_BIT)) {
+    // Check if the frame is a S-frame (or U-frame)
     // Check if S-frame type is a Receive Ready (ACK)
     if (((control >> YAHDLC_CONTROL_S_FRAME_TYPE_BIT) & 0x3)
         == YAHDLC_CONTROL_TYPE_RECEIVE_READY) {
@@ -98,6 +109,10 @@ unsigned char yahdlc_frame_control_type(yahdlc_control_t *control) {
       value |= (YAHDLC_CONTROL_TYPE_REJECT << YAHDLC_CONTROL_S_FRAME_TYPE_BIT);
       value |= (1 << YAHDLC_CONTROL_S_OR_U_FRAME_BIT);
       break;
+    case YAHDLC_FRAME_XID:
+      // Create the HDLC XID U-frame control byte with Poll/Final bit set
+      value = YAHDLC_CONTROL_U_FRAME_XID | (1 << YAHDLC_CONTROL_POLL_BIT);
+      break;
   }
 
   return value;
@@ -112,6 +127,47 @@ void yahdlc_get_data_reset_with_state(yahdlc_state_t *state) {
   state->start_index = state->end_index = -1;
   state->src_index = state->dest_index = 0;
   state->control_escape = 0;
+  state->value_index = 0;
+  state->cobs_code = state->cobs_left = 0;
+}
+
+static void yahdlc_get_data_value(yahdlc_state_t *state,
+                                  yahdlc_control_t *control, char *dest,
+                                  char value) {
+  // Now update the FCS value
+  state->fcs = calc_fcs(state->fcs, value);
+
+  if (state->value_index == 0) {
+    // Address field is the first value after the start flag sequence
+    state->address = value;
+  } else if (state->value_index == 1) {
+    // Control field is the second value after the start flag sequence
+    *control = yahdlc_get_control_type(value);
+  } else {
+    // Start adding the data values after the Control field to the buffer
+    dest[state->dest_index++] = value;
+  }
+
+  state->value_index++;
+}
+
+static void yahdlc_get_data_cobs(yahdlc_state_t *state,
+                                 yahdlc_control_t *control, char *dest,
+                                 char value) {
+  if (state->cobs_left) {
+    // Values within a block are sent as is
+    state->cobs_left--;
+    yahdlc_get_data_value(state, control, dest, value);
+  } else {
+    // A new code byte ends the previous block with a flag sequence value
+    // unless it was a full block (or the first code byte of the frame)
+    if (state->cobs_code != 0xFF) {
+      yahdlc_get_data_value(state, control, dest, YAHDLC_FLAG_SEQUENCE);
+    }
+
+    state->cobs_code = value ^ YAHDLC_FLAG_SEQUENCE;
+    state->cobs_left = state->cobs_code - 1;
+  }
 }
 
 int yahdlc_get_data(yahdlc_control_t *control, const char *src,
@@ -122,7 +178,6 @@ int yahdlc_get_data(yahdlc_control_t *control, const char *src,
 int yahdlc_get_data_with_state(yahdlc_state_t *state, yahdlc_control_t *control, const char *src,
                     unsigned int src_len, char *dest, unsigned int *dest_len) {
   int ret;
-  char value;
   unsigned int i;
 
   // Make sure that all parameters are valid
@@ -146,36 +201,35 @@ int yahdlc_get_data_with_state(yahdlc_state_t *state, yahdlc_control_t *control,
     } else {
       // Check for end flag sequence
       if (src[i] == YAHDLC_FLAG_SEQUENCE) {
-        // Check if an additional flag sequence byte is present or earlier received
-        if (((i < (src_len - 1)) && (src[i + 1] == YAHDLC_FLAG_SEQUENCE))
+        if (state->control_escape) {
+          // A control escape followed by a flag sequence aborts the frame, so silently drop
+          // the received part and use the flag sequence as start of the next frame
+          yahdlc_get_data_reset_with_state(state);
+          state->start_index = state->src_index;
+        } else if (((i < (src_len - 1)) && (src[i + 1] == YAHDLC_FLAG_SEQUENCE))
             || ((state->start_index + 1) == state->src_index)) {
-          // Just loop again to silently discard it (accordingly to HDLC)
+          // Check if an additional flag sequence byte is present or earlier received
+          // and just loop again to silently discard it (accordingly to HDLC)
           continue;
+        } else {
+          state->end_index = state->src_index;
+          break;
         }
-
-        state->end_index = state->src_index;
-        break;
+      } else if (state->cobs_code) {
+        yahdlc_get_data_cobs(state, control, dest, src[i]);
       } else if (src[i] == YAHDLC_CONTROL_ESCAPE) {
         state->control_escape = 1;
-      } else {
-        // Update the value based on any control escape received
-        if (state->control_escape) {
-          state->control_escape = 0;
-          value = src[i] ^ 0x20;
-        } else {
-          value = src[i];
-        }
+      } else if (state->control_escape) {
+        state->control_escape = 0;
 
-        // Now update the FCS value
-        state->fcs = calc_fcs(state->fcs, value);
-
-        if (state->src_index == state->start_index + 2) {
-          // Control field is the second byte after the start flag sequence
-          *control = yahdlc_get_control_type(value);
-        } else if (state->src_index > (state->start_index + 2)) {
-          // Start adding the data values after the Control field to the buffer
-          dest[state->dest_index++] = value;
+        // The COBS marker can only follow the start flag sequence
+        if ((src[i] == YAHDLC_COBS_MARKER) && !state->value_index) {
+          state->cobs_code = 0xFF;
+        } else {
+          yahdlc_get_data_value(state, control, dest, src[i] ^ 0x20);
         }
+      } else {
+        yahdlc_get_data_value(state, control, dest, src[i]);
       }
     }
     state->src_index++;
@@ -187,8 +241,8 @@ int yahdlc_get_data_with_state(yahdlc_state_t *state, yahdlc_control_t *control,
     *dest_len = 0;
     ret = -ENOMSG;
   } else {
-    // A frame is at least 4 bytes in size and has a valid FCS value
-    if ((state->end_index < (state->start_index + 4))
+    // A frame contains at least the address, control and FCS fields and has a valid FCS value
+    if ((state->value_index < (int) (2 + sizeof(state->fcs)))
         || (state->fcs != FCS_GOOD_VALUE)) {
       // Return FCS error and indicate that data up to end flag sequence in buffer should be discarded
       *dest_len = i;
@@ -208,8 +262,251 @@ int yahdlc_get_data_with_state(yahdlc_state_t *state, yahdlc_control_t *control,
 
 int yahdlc_frame_data(yahdlc_control_t *control, const char *src,
                       unsigned int src_len, char *dest, unsigned int *dest_len) {
+  return yahdlc_frame_data_with_address(YAHDLC_ALL_STATION_ADDR, control, src,
+                                        src_len, dest, dest_len);
+}
+
+int yahdlc_frame_data_with_address(unsigned char address,
+                                   yahdlc_control_t *control, const char *src,
+                                   unsigned int src_len, char *dest,
+                                   unsigned int *dest_len) {
+  unsigned int len, dest_index = 0;
+  yahdlc_encoder_t encoder;
+
+  // Make sure that all parameters are valid
+  if (!control || (!src && (src_len > 0)) || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  yahdlc_frame_begin(&encoder, address, control, dest, &len);
+  dest_index += len;
+  yahdlc_frame_append(&encoder, src, src_len, &dest[dest_index], &len);
+  dest_index += len;
+  yahdlc_frame_finish(&encoder, &dest[dest_index], &len);
+  *dest_len = dest_index + len;
+
+  return 0;
+}
+
+int yahdlc_frame_begin(yahdlc_encoder_t *encoder, unsigned char address,
+                       yahdlc_control_t *control, char *dest,
+                       unsigned int *dest_len) {
+  int dest_index = 0;
+  unsigned char value;
+
+  // Make sure that all parameters are valid
+  if (!encoder || !control || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  encoder->fcs = FCS_INIT_VALUE;
+
+  // Only DATA and XID frames should contain data
+  encoder->data = (control->frame == YAHDLC_FRAME_DATA)
+      || (control->frame == YAHDLC_FRAME_XID);
+
+  // Start by adding the start flag sequence
+  dest[dest_index++] = YAHDLC_FLAG_SEQUENCE;
+
+  // Add the address field
+  encoder->fcs = calc_fcs(encoder->fcs, address);
+  yahdlc_escape_value(address, dest, &dest_index);
+
+  // Add the framed control field value
+  value = yahdlc_frame_control_type(control);
+  encoder->fcs = calc_fcs(encoder->fcs, value);
+  yahdlc_escape_value(value, dest, &dest_index);
+
+  *dest_len = dest_index;
+  return 0;
+}
+
+int yahdlc_frame_append(yahdlc_encoder_t *encoder, const char *src,
+                        unsigned int src_len, char *dest,
+                        unsigned int *dest_len) {
   unsigned int i;
   int dest_index = 0;
+
+  // Make sure that all parameters are valid
+  if (!encoder || (!src && (src_len > 0)) || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  if (encoder->data) {
+    // Calculate FCS and escape data
+    for (i = 0; i < src_len; i++) {
+      encoder->fcs = calc_fcs(encoder->fcs, src[i]);
+      yahdlc_escape_value(src[i], dest, &dest_index);
+    }
+  }
+
+  *dest_len = dest_index;
+  return 0;
+}
+
+int yahdlc_frame_finish(yahdlc_encoder_t *encoder, char *dest,
+                        unsigned int *dest_len) {
+  unsigned int i;
+  int dest_index = 0;
+  unsigned char value;
+  FCS_SIZE fcs;
+
+  // Make sure that all parameters are valid
+  if (!encoder || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  // Invert the FCS value accordingly to the specification
+  fcs = encoder->fcs ^ FCS_INVERT_MASK;
+
+  // Run through the FCS bytes and escape the values
+  for (i = 0; i < sizeof(fcs); i++) {
+    value = ((fcs >> (8 * i)) & 0xFF);
+    yahdlc_escape_value(value, dest, &dest_index);
+  }
+
+  // Add end flag sequence and update length of frame
+  dest[dest_index++] = YAHDLC_FLAG_SEQUENCE;
+  *dest_len = dest_index;
+
+  return 0;
+}
+
+static int yahdlc_escaped_size(unsigned char value) {
+  return ((value == YAHDLC_FLAG_SEQUENCE) || (value == YAHDLC_CONTROL_ESCAPE)) ? 2 : 1;
+}
+
+static void yahdlc_ring_escape_value(char value, char *ring,
+                                     unsigned int ring_size,
+                                     unsigned int *head) {
+  // Check and escape the value if needed
+  if ((value == YAHDLC_FLAG_SEQUENCE) || (value == YAHDLC_CONTROL_ESCAPE)) {
+    ring[*head] = YAHDLC_CONTROL_ESCAPE;
+    *head = ((*head + 1) == ring_size) ? 0 : (*head + 1);
+    value ^= 0x20;
+  }
+
+  // Add the value to the ring and wrap around at the end
+  ring[*head] = value;
+  *head = ((*head + 1) == ring_size) ? 0 : (*head + 1);
+}
+
+int yahdlc_frame_data_ring(yahdlc_control_t *control, const char *src,
+                           unsigned int src_len, char *ring,
+                           unsigned int ring_size, unsigned int head,
+                           unsigned int tail) {
+  unsigned int i, size, space;
+  unsigned char value;
+  FCS_SIZE fcs = FCS_INIT_VALUE;
+
+  // Make sure that all parameters are valid
+  if (!control || (!src && (src_len > 0)) || !ring || (ring_size < 2)
+      || (head >= ring_size) || (tail >= ring_size)) {
+    return -EINVAL;
+  }
+
+  // Only DATA and XID frames should contain data
+  if ((control->frame != YAHDLC_FRAME_DATA)
+      && (control->frame != YAHDLC_FRAME_XID)) {
+    src_len = 0;
+  }
+
+  // Larger data would overflow the frame size calculation
+  if (src_len > YAHDLC_FRAME_DATA_SIZE_MAX) {
+    return -ENOBUFS;
+  }
+
+  // One byte is kept free so a full ring can be told apart from an empty one
+  space = ring_size - 1 - ((head + ring_size - tail) % ring_size);
+
+  // Calculate the exact frame size when the worst case (every value escaped)
+  // does not fit, so nothing is written unless the whole frame fits
+  size = (2 * (src_len + 2 + sizeof(fcs))) + 2;
+  if (size > space) {
+    value = yahdlc_frame_control_type(control);
+    size = 2 + yahdlc_escaped_size(YAHDLC_ALL_STATION_ADDR) + yahdlc_escaped_size(value);
+    fcs = calc_fcs(calc_fcs(fcs, YAHDLC_ALL_STATION_ADDR), value);
+
+    for (i = 0; i < src_len; i++) {
+      fcs = calc_fcs(fcs, src[i]);
+      size += yahdlc_escaped_size(src[i]);
+    }
+
+    fcs ^= FCS_INVERT_MASK;
+    for (i = 0; i < sizeof(fcs); i++) {
+      size += yahdlc_escaped_size((fcs >> (8 * i)) & 0xFF);
+    }
+
+    if (size > space) {
+      return -ENOBUFS;
+    }
+
+    fcs = FCS_INIT_VALUE;
+  }
+
+  // Start by adding the start flag sequence
+  ring[head] = YAHDLC_FLAG_SEQUENCE;
+  head = ((head + 1) == ring_size) ? 0 : (head + 1);
+
+  // Add the address field
+  fcs = calc_fcs(fcs, YAHDLC_ALL_STATION_ADDR);
+  yahdlc_ring_escape_value(YAHDLC_ALL_STATION_ADDR, ring, ring_size, &head);
+
+  // Add the framed control field value
+  value = yahdlc_frame_control_type(control);
+  fcs = calc_fcs(fcs, value);
+  yahdlc_ring_escape_value(value, ring, ring_size, &head);
+
+  // Calculate FCS and escape data
+  for (i = 0; i < src_len; i++) {
+    fcs = calc_fcs(fcs, src[i]);
+    yahdlc_ring_escape_value(src[i], ring, ring_size, &head);
+  }
+
+  // Invert the FCS value accordingly to the specification
+  fcs ^= FCS_INVERT_MASK;
+
+  // Run through the FCS bytes and escape the values
+  for (i = 0; i < sizeof(fcs); i++) {
+    value = ((fcs >> (8 * i)) & 0xFF);
+    yahdlc_ring_escape_value(value, ring, ring_size, &head);
+  }
+
+  // Add end flag sequence and return the new head of the ring
+  ring[head] = YAHDLC_FLAG_SEQUENCE;
+  head = ((head + 1) == ring_size) ? 0 : (head + 1);
+
+  return head;
+}
+
+static void yahdlc_cobs_end_block(char *dest, int *dest_index,
+                                  int *code_index) {
+  // The code byte holds the block length and is stored with the flag sequence
+  // value XOR'ed in, so it can never be a flag sequence itself
+  dest[*code_index] = (*dest_index - *code_index) ^ YAHDLC_FLAG_SEQUENCE;
+  *code_index = (*dest_index)++;
+}
+
+static void yahdlc_cobs_value(char value, char *dest, int *dest_index,
+                              int *code_index) {
+  // Flag sequence values are replaced by ending the current block
+  if (value == YAHDLC_FLAG_SEQUENCE) {
+    yahdlc_cobs_end_block(dest, dest_index, code_index);
+  } else {
+    dest[(*dest_index)++] = value;
+
+    // A full block ends without an implicit flag sequence value
+    if ((*dest_index - *code_index) == 0xFF) {
+      yahdlc_cobs_end_block(dest, dest_index, code_index);
+    }
+  }
+}
+
+int yahdlc_frame_data_cobs(yahdlc_control_t *control, const char *src,
+                           unsigned int src_len, char *dest,
+                           unsigned int *dest_len) {
+  unsigned int i;
+  int dest_index = 0, code_index;
   unsigned char value = 0;
   FCS_SIZE fcs = FCS_INIT_VALUE;
 
@@ -218,37 +515,43 @@ int yahdlc_frame_data(yahdlc_control_t *control, const char *src,
     return -EINVAL;
   }
 
-  // Start by adding the start flag sequence
+  // Start by adding the start flag sequence followed by the COBS marker
   dest[dest_index++] = YAHDLC_FLAG_SEQUENCE;
+  dest[dest_index++] = YAHDLC_CONTROL_ESCAPE;
+  dest[dest_index++] = YAHDLC_COBS_MARKER;
+
+  // Reserve the code byte of the first block
+  code_index = dest_index++;
 
   // Add the all-station address from HDLC (broadcast)
   fcs = calc_fcs(fcs, YAHDLC_ALL_STATION_ADDR);
-  yahdlc_escape_value(YAHDLC_ALL_STATION_ADDR, dest, &dest_index);
+  yahdlc_cobs_value(YAHDLC_ALL_STATION_ADDR, dest, &dest_index, &code_index);
 
   // Add the framed control field value
   value = yahdlc_frame_control_type(control);
   fcs = calc_fcs(fcs, value);
-  yahdlc_escape_value(value, dest, &dest_index);
+  yahdlc_cobs_value(value, dest, &dest_index, &code_index);
 
-  // Only DATA frames should contain data
-  if (control->frame == YAHDLC_FRAME_DATA) {
-    // Calculate FCS and escape data
+  // Only DATA and XID frames should contain data
+  if ((control->frame == YAHDLC_FRAME_DATA)
+      || (control->frame == YAHDLC_FRAME_XID)) {
     for (i = 0; i < src_len; i++) {
       fcs = calc_fcs(fcs, src[i]);
-      yahdlc_escape_value(src[i], dest, &dest_index);
+      yahdlc_cobs_value(src[i], dest, &dest_index, &code_index);
     }
   }
 
   // Invert the FCS value accordingly to the specification
   fcs ^= FCS_INVERT_MASK;
 
-  // Run through the FCS bytes and escape the values
   for (i = 0; i < sizeof(fcs); i++) {
     value = ((fcs >> (8 * i)) & 0xFF);
-    yahdlc_escape_value(value, dest, &dest_index);
+    yahdlc_cobs_value(value, dest, &dest_index, &code_index);
   }
 
-  // Add end flag sequence and update length of frame
+  // End the last block (its implicit flag sequence value is discarded by the
+  // receiver) and add end flag sequence
+  dest[code_index] = (dest_index - code_index) ^ YAHDLC_FLAG_SEQUENCE;
   dest[dest_index++] = YAHDLC_FLAG_SEQUENCE;
   *dest_len = dest_index;
 
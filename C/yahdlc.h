@@ -7,6 +7,7 @@
 
 #include "fcs.h"
 #include <errno.h>
+#include <limits.h>
 
 /** HDLC start/end flag sequence */
 #define YAHDLC_FLAG_SEQUENCE 0x7E
@@ -14,14 +15,28 @@
 /** HDLC control escape value */
 #define YAHDLC_CONTROL_ESCAPE 0x7D
 
+/** Value following a control escape after the start flag sequence to signal
+ * that the frame uses consistent overhead byte stuffing (COBS) instead of
+ * control escapes
+ */
+#define YAHDLC_COBS_MARKER 0x01
+
+/** Largest data size whose worst-case frame size (every value escaped) fits
+ * into an unsigned int
+ */
+#define YAHDLC_FRAME_DATA_SIZE_MAX (((UINT_MAX - 2) / 2) - 2 - sizeof(FCS_SIZE))
+
 /** HDLC all station address */
 #define YAHDLC_ALL_STATION_ADDR 0xFF
 
-/** Supported HDLC frame types */
+/** Supported HDLC frame types (XID is the U-frame used to negotiate link
+ * parameters, see yahdlc_xid.h, and carries data like DATA frames)
+ */
 typedef enum {
   YAHDLC_FRAME_DATA,
   YAHDLC_FRAME_ACK,
   YAHDLC_FRAME_NACK,
+  YAHDLC_FRAME_XID,
 } yahdlc_frame_t;
 
 /** Control field information */
@@ -31,17 +46,36 @@ typedef struct {
 } yahdlc_control_t;
 
 /** Variables used in yahdlc_get_data and yahdlc_get_data_with_state
- * to keep track of received buffers
+ * to keep track of received buffers. The address field of the last decoded
+ * frame is kept in address until the address field of the next frame is received.
  */
 typedef struct {
   char control_escape;
+  unsigned char address;
   FCS_SIZE fcs;
   int start_index;
   int end_index;
   int src_index;
   int dest_index;
+  int value_index;
+  unsigned char cobs_code;
+  unsigned char cobs_left;
 } yahdlc_state_t;
 
+/** Maximum output of yahdlc_frame_begin (flag sequence and escaped address and control fields) */
+#define YAHDLC_FRAME_BEGIN_SIZE_MAX 5
+
+/** Maximum output of yahdlc_frame_finish (escaped FCS and flag sequence) */
+#define YAHDLC_FRAME_FINISH_SIZE_MAX ((2 * sizeof(FCS_SIZE)) + 1)
+
+/** Streaming encoder state used by yahdlc_frame_begin, yahdlc_frame_append
+ * and yahdlc_frame_finish
+ */
+typedef struct {
+  FCS_SIZE fcs;
+  char data;
+} yahdlc_encoder_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -91,6 +125,9 @@ int yahdlc_get_data(yahdlc_control_t *control, const char *src,
  * The difference is only in first argument: yahdlc_state_t *state
  * Data under that pointer is used to keep track of internal buffers.
  *
+ * A frame aborted by the sender (control escape followed by a flag sequence)
+ * is silently discarded and the flag sequence starts the next frame.
+ *
  * @see yahdlc_get_data
  */
 int yahdlc_get_data_with_state(yahdlc_state_t *state, yahdlc_control_t *control, const char *src,
@@ -127,6 +164,127 @@ void yahdlc_get_data_reset_with_state(yahdlc_state_t *state);
 int yahdlc_frame_data(yahdlc_control_t *control, const char *src,
                       unsigned int src_len, char *dest, unsigned int *dest_len);
 
+/**
+ * This is a variation of @ref yahdlc_frame_data which uses the specified
+ * address field instead of the all-station address. The address field can be
+ * used as logical channel id when multiplexing data over a single link. The
+ * address field of a received frame is available in yahdlc_state_t.
+ *
+ * @param[in] address Address field of the frame
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_frame_data_with_address(unsigned char address,
+                                   yahdlc_control_t *control, const char *src,
+                                   unsigned int src_len, char *dest,
+                                   unsigned int *dest_len);
+
+/**
+ * This is a variation of @ref yahdlc_frame_data which uses consistent overhead
+ * byte stuffing (COBS) instead of control escapes to remove flag sequence
+ * values from the frame. The frame overhead is bounded to one byte per 254
+ * bytes (plus two bytes for the COBS marker), whereas control escapes can
+ * double the size of the frame. The flag sequence delimiting and FCS are kept,
+ * and the frames are decoded by @ref yahdlc_get_data as well. The peer must
+ * support COBS frames, as older versions will report them as invalid FCS, so
+ * the mode should only be used after it has been negotiated with XID frames
+ * (see yahdlc_xid_negotiate).
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_frame_data_cobs(yahdlc_control_t *control, const char *src,
+                           unsigned int src_len, char *dest,
+                           unsigned int *dest_len);
+
+/**
+ * This is a variation of @ref yahdlc_frame_data which writes the frame
+ * directly into a circular buffer (e.g. a DMA transmit ring), wrapping around
+ * at the end of the buffer. The frame is only written if it fits completely
+ * into the free space between head and tail (one byte of the ring is always
+ * kept free to tell a full ring from an empty one).
+ *
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[in] src Source buffer with data
+ * @param[in] src_len Source buffer length
+ * @param[out] ring Ring buffer
+ * @param[in] ring_size Ring buffer size
+ * @param[in] head Position in the ring where the frame is written
+ * @param[in] tail Position in the ring of the first byte not yet sent
+ * @retval >=0 Success (new head position after the frame)
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOBUFS Not enough free space in the ring or src_len above
+ * YAHDLC_FRAME_DATA_SIZE_MAX (nothing written)
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_frame_data_ring(yahdlc_control_t *control, const char *src,
+                           unsigned int src_len, char *ring,
+                           unsigned int ring_size, unsigned int head,
+                           unsigned int tail);
+
+/**
+ * Starts a frame whose data is added in chunks with @ref yahdlc_frame_append
+ * and which is completed with @ref yahdlc_frame_finish. This allows sending
+ * data of unknown length with constant memory, and each call writes its part
+ * of the frame, so it can be sent before the rest of the data exists.
+ *
+ * @param[out] encoder Encoder state
+ * @param[in] address Address field of the frame
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[out] dest Destination buffer (at least YAHDLC_FRAME_BEGIN_SIZE_MAX bytes)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_frame_begin(yahdlc_encoder_t *encoder, unsigned char address,
+                       yahdlc_control_t *control, char *dest,
+                       unsigned int *dest_len);
+
+/**
+ * Adds data to the frame started with @ref yahdlc_frame_begin (ignored for
+ * other than DATA and XID frames)
+ *
+ * @param[in] encoder Encoder state
+ * @param[in] src Source buffer with data
+ * @param[in] src_len Source buffer length
+ * @param[out] dest Destination buffer (at least twice the source buffer length)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_frame_append(yahdlc_encoder_t *encoder, const char *src,
+                        unsigned int src_len, char *dest,
+                        unsigned int *dest_len);
+
+/**
+ * Completes the frame started with @ref yahdlc_frame_begin by adding the FCS
+ * and the end flag sequence
+ *
+ * @param[in] encoder Encoder state
+ * @param[out] dest Destination buffer (at least YAHDLC_FRAME_FINISH_SIZE_MAX bytes)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_frame_finish(yahdlc_encoder_t *encoder, char *dest,
+                        unsigned int *dest_len);
+
+/**
+ * Converts a received control field value to the control field structure
+ *
+ * @param[in] control Control field value
+ * @returns Control field structure with frame type and sequence number
+ */
+yahdlc_control_t yahdlc_get_control_type(unsigned char control);
+
+/**
+ * Converts the control field structure to the control field value to be sent
+ *
+ * @param[in] control Control field structure with frame type and sequence number
+ * @returns Control field value
+ */
+unsigned char yahdlc_frame_control_type(yahdlc_control_t *control);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,356 @@
+/**
+ * @file yahdlc.hpp
+ *
+ * C++20 coroutine interface for sending and receiving frames over any
+ * asynchronous byte stream
+ */
+
+#ifndef YAHDLC_HPP
+#define YAHDLC_HPP
+
+#include "yahdlc.h"
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <span>
+#include <utility>
+
+// Coroutine frames allocated with arguments are freed with the usual operator
+// delete (as required by the standard), which GCC reports as a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace yahdlc {
+
+/** Size of each per-link coroutine frame slot (larger frames are allocated on the heap) */
+#ifndef YAHDLC_CORO_FRAME_SIZE
+#define YAHDLC_CORO_FRAME_SIZE 512
+#endif
+
+/**
+ * Asynchronous byte stream used by @ref link. async_read_some must return an
+ * awaitable which completes with the number of bytes read (0 at the end of the
+ * stream), and async_write an awaitable which completes when all bytes have
+ * been written. Adapters for e.g. asio sockets or serial ports only need to
+ * wrap the completion handler into an awaitable.
+ */
+template <typename Stream>
+concept byte_stream = requires(Stream &stream, std::span<char> read,
+                               std::span<const char> write) {
+  { stream.async_read_some(read).await_ready() } -> std::convertible_to<bool>;
+  { stream.async_read_some(read).await_resume() } -> std::convertible_to<std::size_t>;
+  { stream.async_write(write).await_ready() } -> std::convertible_to<bool>;
+};
+
+/** Coroutine frame memory owned by a link, so the send and receive coroutines
+ * of a link do not allocate
+ */
+class frame_slot {
+ public:
+  /**
+   * Gets the memory for a coroutine frame
+   *
+   * @param[in] size Size of the coroutine frame
+   * @returns Slot memory or nullptr if the slot is used or too small
+   */
+  void *acquire(std::size_t size) noexcept {
+    if (used_ || (size > sizeof(memory_))) {
+      return nullptr;
+    }
+
+    used_ = true;
+    return memory_;
+  }
+
+  /** Releases the memory of the coroutine frame */
+  void release() noexcept {
+    used_ = false;
+  }
+
+  /** Checks if the slot is used by a coroutine frame */
+  bool used() const noexcept {
+    return used_;
+  }
+
+ private:
+  alignas(std::max_align_t) char memory_[YAHDLC_CORO_FRAME_SIZE];
+  bool used_ = false;
+};
+
+/**
+ * Lazily started coroutine which resumes its awaiter when done. The
+ * coroutine frame is placed in a frame slot if the coroutine is a member of a
+ * class providing frame_slot_for(size) (like @ref link), otherwise it is
+ * allocated on the heap.
+ */
+template <typename T>
+class task {
+ public:
+  struct promise_type {
+    // The frame slot (or nullptr on the heap) is stored in front of the coroutine frame
+    static constexpr std::size_t header_size = alignof(std::max_align_t)
+        * ((sizeof(frame_slot *) + alignof(std::max_align_t) - 1)
+            / alignof(std::max_align_t));
+
+    static void *allocate(frame_slot *slot, std::size_t size) {
+      void *memory = slot ? slot->acquire(header_size + size) : nullptr;
+
+      if (!memory) {
+        slot = nullptr;
+        memory = ::operator new(header_size + size);
+      }
+
+      *static_cast<frame_slot **>(memory) = slot;
+      return static_cast<char *>(memory) + header_size;
+    }
+
+    template <typename Owner, typename... Args>
+      requires requires(Owner &owner, std::size_t size) {
+        { owner.frame_slot_for(size) } -> std::same_as<frame_slot *>;
+      }
+    static void *operator new(std::size_t size, Owner &owner, Args &&...) {
+      return allocate(owner.frame_slot_for(size), size);
+    }
+
+    static void *operator new(std::size_t size) {
+      return allocate(nullptr, size);
+    }
+
+    static void operator delete(void *frame) noexcept {
+      void *memory = static_cast<char *>(frame) - header_size;
+      frame_slot *slot = *static_cast<frame_slot **>(memory);
+
+      if (slot) {
+        slot->release();
+      } else {
+        ::operator delete(memory);
+      }
+    }
+
+    // Resumes the awaiting coroutine (symmetric transfer) when done
+    struct final_awaiter {
+      bool await_ready() noexcept {
+        return false;
+      }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        if (handle.promise().continuation) {
+          return handle.promise().continuation;
+        }
+        return std::noop_coroutine();
+      }
+
+      void await_resume() noexcept {
+      }
+    };
+
+    task get_return_object() noexcept {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+      return {};
+    }
+
+    final_awaiter final_suspend() noexcept {
+      return {};
+    }
+
+    void return_value(T result) {
+      value = std::move(result);
+    }
+
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    T value{};
+  };
+
+  task(task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+  }
+
+  task(const task &) = delete;
+  task &operator=(const task &) = delete;
+
+  ~task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+
+  T await_resume() {
+    return result();
+  }
+
+  /** Starts the coroutine when it is not awaited by another coroutine */
+  void start() {
+    handle_.resume();
+  }
+
+  /** Checks if the coroutine is done */
+  bool done() const noexcept {
+    return handle_.done();
+  }
+
+  /** Gets the result when done (rethrows an exception of the coroutine) */
+  T result() {
+    if (handle_.promise().exception) {
+      std::rethrow_exception(handle_.promise().exception);
+    }
+    return std::move(handle_.promise().value);
+  }
+
+ private:
+  explicit task(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+/** Frame received by @ref link::receive_frame */
+struct frame {
+  /** 0 on success, -EIO on invalid FCS, -ENOBUFS if the frame is larger than
+   * the link buffer or -EPIPE at the end of the stream
+   */
+  int status;
+  unsigned char address;
+  yahdlc_control_t control;
+  /** Frame data (valid until the next receive) */
+  std::span<const char> data;
+};
+
+/**
+ * Sends and receives frames over an asynchronous byte stream. Frames are
+ * decoded incrementally from whatever the stream returns, so many links can
+ * share a few threads. At most one send and one receive can be outstanding at
+ * a time, and their coroutine frames use the slots of the link.
+ *
+ * @tparam Stream Asynchronous byte stream
+ * @tparam MaxData Maximum frame data size
+ */
+template <byte_stream Stream, std::size_t MaxData = 1024>
+class link {
+ public:
+  explicit link(Stream &stream) noexcept : stream_(stream) {
+    yahdlc_get_data_reset_with_state(&state_);
+  }
+
+  link(const link &) = delete;
+  link &operator=(const link &) = delete;
+
+  /**
+   * Receives the next frame
+   *
+   * @returns Received frame (check status)
+   */
+  task<frame> receive_frame() {
+    int ret;
+    unsigned int len, dest_len;
+
+    for (;;) {
+      if (rx_begin_ == rx_end_) {
+        rx_begin_ = 0;
+        rx_end_ = co_await stream_.async_read_some(std::span<char>(rx_buffer_));
+        if (!rx_end_) {
+          co_return frame{ -EPIPE, 0, {}, {} };
+        }
+      }
+
+      // Never pass more values than the frame buffer has room for
+      len = rx_end_ - rx_begin_;
+      if (len > (sizeof(frame_buffer_) - state_.dest_index)) {
+        len = sizeof(frame_buffer_) - state_.dest_index;
+      }
+
+      yahdlc_control_t control;
+      ret = yahdlc_get_data_with_state(&state_, &control, &rx_buffer_[rx_begin_],
+                                       len, frame_buffer_, &dest_len);
+      if ((ret >= 0) && (dest_len > MaxData)) {
+        rx_begin_ += ret;
+        co_return frame{ -ENOBUFS, 0, {}, {} };
+      } else if (ret >= 0) {
+        rx_begin_ += ret;
+        co_return frame{ 0, state_.address, control,
+                         std::span<const char>(frame_buffer_, dest_len) };
+      } else if (ret == -EIO) {
+        rx_begin_ += dest_len;
+        co_return frame{ -EIO, 0, {}, {} };
+      }
+
+      rx_begin_ += len;
+      if (state_.dest_index >= (int) sizeof(frame_buffer_)) {
+        // Drop the frame and wait for the next flag sequence
+        yahdlc_get_data_reset_with_state(&state_);
+        co_return frame{ -ENOBUFS, 0, {}, {} };
+      }
+    }
+  }
+
+  /**
+   * Sends a frame
+   *
+   * @param[in] control Control field structure with frame type and sequence number
+   * @param[in] data Frame data
+   * @retval 0 Success
+   * @retval -EINVAL Invalid parameter
+   */
+  task<int> send(yahdlc_control_t control, std::span<const char> data) {
+    int ret;
+    unsigned int len;
+
+    if (data.size() > MaxData) {
+      co_return -EINVAL;
+    }
+
+    ret = yahdlc_frame_data(&control, data.data(), data.size(), tx_buffer_, &len);
+    if (ret) {
+      co_return ret;
+    }
+
+    co_await stream_.async_write(std::span<const char>(tx_buffer_, len));
+    co_return 0;
+  }
+
+  /** Gets the frame slot for a coroutine of the link */
+  frame_slot *frame_slot_for(std::size_t) noexcept {
+    return slots_[0].used() ? &slots_[1] : &slots_[0];
+  }
+
+ private:
+  Stream &stream_;
+  yahdlc_state_t state_;
+  unsigned int rx_begin_ = 0;
+  unsigned int rx_end_ = 0;
+  frame_slot slots_[2];
+  char rx_buffer_[256];
+  // Room for one more value than a valid frame to detect too large frames
+  char frame_buffer_[MaxData + sizeof(FCS_SIZE) + 1];
+  // Every value can be escaped (plus flag sequences, address and control)
+  char tx_buffer_[2 * (MaxData + 2 + sizeof(FCS_SIZE)) + 2];
+};
+
+}  // namespace yahdlc
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
@@ -0,0 +1,317 @@
+#include "yahdlc_bit.h"
+#include <pthread.h>
+#include <string.h>
+
+// Number of ones after which a zero bit is inserted
+#define YAHDLC_BIT_STUFF_ONES 5
+
+// Number of bits of a flag sequence (a zero followed by five ones) which have
+// been added as data bits when the flag sequence is found
+#define YAHDLC_BIT_FLAG_RETRACT 6
+
+// Encoded bits of a byte (up to 10 bits with the inserted zeros) and the
+// number of consecutive ones at the end
+typedef struct {
+  unsigned short bits;
+  unsigned char count;
+  unsigned char ones;
+} yahdlc_bit_encode_t;
+
+// Decoded data bits of a byte split into segments by the events (flag
+// sequence or abort) found within the byte, and the number of consecutive ones
+// at the end (seven means seven or more)
+typedef struct {
+  unsigned char ones;
+  unsigned char events;
+  unsigned char event[2];
+  unsigned char bits[3];
+  unsigned char count[3];
+} yahdlc_bit_decode_t;
+
+static yahdlc_bit_encode_t yahdlc_bit_encode_table[YAHDLC_BIT_STUFF_ONES][256];
+static yahdlc_bit_decode_t yahdlc_bit_decode_table[8][256];
+static pthread_once_t yahdlc_bit_tables_once = PTHREAD_ONCE_INIT;
+
+static void yahdlc_bit_build_tables(void) {
+  unsigned int ones, value, bit, i;
+  yahdlc_bit_encode_t *encode;
+  yahdlc_bit_decode_t *decode;
+
+  // Run each byte bit by bit through the encoder for every number of ones
+  // received before it
+  for (ones = 0; ones < YAHDLC_BIT_STUFF_ONES; ones++) {
+    for (value = 0; value < 256; value++) {
+      encode = &yahdlc_bit_encode_table[ones][value];
+      encode->bits = encode->count = 0;
+      encode->ones = ones;
+
+      for (i = 0; i < 8; i++) {
+        bit = (value >> i) & 1;
+        encode->bits |= bit << encode->count++;
+
+        if (!bit) {
+          encode->ones = 0;
+        } else if (++encode->ones == YAHDLC_BIT_STUFF_ONES) {
+          // Insert a zero bit after five consecutive ones
+          encode->count++;
+          encode->ones = 0;
+        }
+      }
+    }
+  }
+
+  // Run each byte bit by bit through the decoder for every number of ones
+  // received before it
+  for (ones = 0; ones < 8; ones++) {
+    for (value = 0; value < 256; value++) {
+      decode = &yahdlc_bit_decode_table[ones][value];
+      memset(decode, 0, sizeof(*decode));
+      decode->ones = ones;
+
+      for (i = 0; i < 8; i++) {
+        bit = (value >> i) & 1;
+
+        if (bit) {
+          // The sixth one can only be part of a flag sequence or abort
+          if (decode->ones < YAHDLC_BIT_STUFF_ONES) {
+            decode->bits[decode->events] |= 1 << decode->count[decode->events]++;
+          }
+
+          if (decode->ones < 7) {
+            if (++decode->ones == 7) {
+              decode->event[decode->events++] = YAHDLC_BIT_EVENT_ABORT;
+            }
+          }
+        } else {
+          if (decode->ones == 6) {
+            decode->event[decode->events++] = YAHDLC_BIT_EVENT_FLAG;
+          } else if (decode->ones < YAHDLC_BIT_STUFF_ONES) {
+            decode->count[decode->events]++;
+          }
+
+          // A zero after five ones is an inserted zero and is dropped, and a
+          // zero after seven or more ones ends the idle or abort sequence
+          decode->ones = 0;
+        }
+      }
+    }
+  }
+}
+
+void yahdlc_bit_init(void) {
+  pthread_once(&yahdlc_bit_tables_once, yahdlc_bit_build_tables);
+}
+
+void yahdlc_bit_encoder_init(yahdlc_bit_encoder_t *encoder) {
+  yahdlc_bit_init();
+  memset(encoder, 0, sizeof(*encoder));
+}
+
+static void yahdlc_bit_put(yahdlc_bit_encoder_t *encoder, unsigned int bits,
+                           unsigned int count, char *dest,
+                           unsigned int *dest_index) {
+  encoder->bits |= (unsigned long) bits << encoder->bit_count;
+  encoder->bit_count += count;
+
+  while (encoder->bit_count >= 8) {
+    dest[(*dest_index)++] = encoder->bits & 0xFF;
+    encoder->bits >>= 8;
+    encoder->bit_count -= 8;
+  }
+}
+
+static void yahdlc_bit_put_value(yahdlc_bit_encoder_t *encoder,
+                                 unsigned char value, char *dest,
+                                 unsigned int *dest_index) {
+  const yahdlc_bit_encode_t *encode =
+      &yahdlc_bit_encode_table[encoder->ones][value];
+
+  encoder->ones = encode->ones;
+  yahdlc_bit_put(encoder, encode->bits, encode->count, dest, dest_index);
+}
+
+int yahdlc_bit_frame_data(yahdlc_bit_encoder_t *encoder,
+                          yahdlc_control_t *control, const char *src,
+                          unsigned int src_len, char *dest,
+                          unsigned int *dest_len) {
+  unsigned int i, dest_index = 0;
+  unsigned char value;
+  FCS_SIZE fcs = FCS_INIT_VALUE;
+
+  // Make sure that all parameters are valid
+  if (!encoder || !control || (!src && (src_len > 0)) || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  // Start by adding the start flag sequence (which is never bit stuffed)
+  yahdlc_bit_put(encoder, YAHDLC_FLAG_SEQUENCE, 8, dest, &dest_index);
+  encoder->ones = 0;
+
+  // Add the address field
+  fcs = calc_fcs(fcs, YAHDLC_ALL_STATION_ADDR);
+  yahdlc_bit_put_value(encoder, YAHDLC_ALL_STATION_ADDR, dest, &dest_index);
+
+  // Add the framed control field value
+  value = yahdlc_frame_control_type(control);
+  fcs = calc_fcs(fcs, value);
+  yahdlc_bit_put_value(encoder, value, dest, &dest_index);
+
+  // Only DATA and XID frames should contain data
+  if ((control->frame == YAHDLC_FRAME_DATA)
+      || (control->frame == YAHDLC_FRAME_XID)) {
+    for (i = 0; i < src_len; i++) {
+      fcs = calc_fcs(fcs, src[i]);
+      yahdlc_bit_put_value(encoder, src[i], dest, &dest_index);
+    }
+  }
+
+  // Invert the FCS value accordingly to the specification
+  fcs ^= FCS_INVERT_MASK;
+
+  for (i = 0; i < sizeof(fcs); i++) {
+    yahdlc_bit_put_value(encoder, (fcs >> (8 * i)) & 0xFF, dest, &dest_index);
+  }
+
+  // Add end flag sequence and update length of frame
+  yahdlc_bit_put(encoder, YAHDLC_FLAG_SEQUENCE, 8, dest, &dest_index);
+  encoder->ones = 0;
+  *dest_len = dest_index;
+
+  return 0;
+}
+
+unsigned int yahdlc_bit_flush(yahdlc_bit_encoder_t *encoder, char *dest) {
+  if (!encoder || !dest || !encoder->bit_count) {
+    return 0;
+  }
+
+  dest[0] = (encoder->bits | (0xFF << encoder->bit_count)) & 0xFF;
+  encoder->bits = encoder->bit_count = 0;
+  return 1;
+}
+
+int yahdlc_bit_decoder_init(yahdlc_bit_decoder_t *decoder, char *buffer,
+                            unsigned int buffer_size) {
+  // Make sure that all parameters are valid
+  if (!decoder || !buffer) {
+    return -EINVAL;
+  }
+
+  yahdlc_bit_init();
+  memset(decoder, 0, sizeof(*decoder));
+  decoder->buffer = buffer;
+  decoder->buffer_size = buffer_size;
+
+  // Wait for the first flag sequence as if an abort was received
+  decoder->ones = 7;
+  return 0;
+}
+
+static void yahdlc_bit_get_value(yahdlc_bit_decoder_t *decoder,
+                                 unsigned char value) {
+  decoder->fcs = calc_fcs(decoder->fcs, value);
+
+  if (decoder->value_index == 0) {
+    decoder->address = value;
+  } else if (decoder->value_index == 1) {
+    decoder->control = value;
+  } else if ((decoder->value_index - 2) < decoder->buffer_size) {
+    decoder->buffer[decoder->value_index - 2] = value;
+  } else {
+    decoder->overflow = 1;
+  }
+
+  decoder->value_index++;
+}
+
+static void yahdlc_bit_get_bits(yahdlc_bit_decoder_t *decoder,
+                                unsigned int bits, unsigned int count) {
+  if (!decoder->in_frame || !count) {
+    return;
+  }
+
+  decoder->bits |= (unsigned long) bits << decoder->bit_count;
+  decoder->bit_count += count;
+
+  // Keep the bits which could turn out to be the start of a flag sequence
+  while (decoder->bit_count >= (8 + YAHDLC_BIT_FLAG_RETRACT)) {
+    yahdlc_bit_get_value(decoder, decoder->bits & 0xFF);
+    decoder->bits >>= 8;
+    decoder->bit_count -= 8;
+  }
+}
+
+static void yahdlc_bit_get_flag(yahdlc_bit_decoder_t *decoder,
+                                yahdlc_bit_frame_t frame, void *arg,
+                                int *frames) {
+  int status = 0;
+  unsigned int len = 0;
+  yahdlc_control_t control;
+
+  if (decoder->in_frame) {
+    // Remove the bits of the flag sequence which were added as data
+    if (decoder->bit_count >= YAHDLC_BIT_FLAG_RETRACT) {
+      decoder->bit_count -= YAHDLC_BIT_FLAG_RETRACT;
+    } else {
+      decoder->bit_count = 0;
+    }
+
+    // Silently discard frames without any value (e.g. between two flag sequences)
+    if (decoder->value_index) {
+      // A frame is a multiple of 8 bits and contains at least the address,
+      // control and FCS fields and has a valid FCS value
+      if (decoder->overflow) {
+        status = -ENOBUFS;
+      } else if (decoder->bit_count
+          || (decoder->value_index < (2 + sizeof(FCS_SIZE)))
+          || (decoder->fcs != FCS_GOOD_VALUE)) {
+        status = -EIO;
+      } else {
+        len = decoder->value_index - 2 - sizeof(FCS_SIZE);
+        (*frames)++;
+      }
+
+      control = yahdlc_get_control_type(decoder->control);
+      frame(arg, decoder->address, &control, decoder->buffer, len, status);
+    }
+  }
+
+  // Every flag sequence can be the start of the next frame
+  decoder->in_frame = 1;
+  decoder->overflow = 0;
+  decoder->bits = decoder->bit_count = 0;
+  decoder->value_index = 0;
+  decoder->fcs = FCS_INIT_VALUE;
+}
+
+int yahdlc_bit_get_data(yahdlc_bit_decoder_t *decoder, const char *src,
+                        unsigned int src_len, yahdlc_bit_frame_t frame,
+                        void *arg) {
+  int frames = 0;
+  unsigned int i, j;
+  const yahdlc_bit_decode_t *decode;
+
+  // Make sure that all parameters are valid
+  if (!decoder || !decoder->buffer || (!src && src_len) || !frame) {
+    return -EINVAL;
+  }
+
+  for (i = 0; i < src_len; i++) {
+    decode = &yahdlc_bit_decode_table[decoder->ones][(unsigned char) src[i]];
+
+    yahdlc_bit_get_bits(decoder, decode->bits[0], decode->count[0]);
+    for (j = 0; j < decode->events; j++) {
+      if (decode->event[j] == YAHDLC_BIT_EVENT_FLAG) {
+        yahdlc_bit_get_flag(decoder, frame, arg, &frames);
+      } else {
+        // Silently drop the aborted frame and wait for the next flag sequence
+        decoder->in_frame = 0;
+      }
+      yahdlc_bit_get_bits(decoder, decode->bits[j + 1], decode->count[j + 1]);
+    }
+
+    decoder->ones = decode->ones;
+  }
+
+  return frames;
+}
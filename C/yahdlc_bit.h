@@ -0,0 +1,140 @@
+/**
+ * @file yahdlc_bit.h
+ */
+
+#ifndef YAHDLC_BIT_H
+#define YAHDLC_BIT_H
+
+#include "yahdlc.h"
+
+/** Per-frame events found by the bit-oriented decoder */
+#define YAHDLC_BIT_EVENT_FLAG 0
+#define YAHDLC_BIT_EVENT_ABORT 1
+
+/** Bit-oriented (bit stuffed) frame encoder. Bits which do not fill a whole
+ * byte are kept until the next frame or @ref yahdlc_bit_flush.
+ */
+typedef struct {
+  unsigned long bits;
+  unsigned int bit_count;
+  unsigned char ones;
+} yahdlc_bit_encoder_t;
+
+/** Bit-oriented (bit stuffed) frame decoder */
+typedef struct {
+  unsigned long bits;
+  unsigned int bit_count;
+  unsigned char ones;
+  char in_frame;
+  char overflow;
+  unsigned char address;
+  unsigned char control;
+  FCS_SIZE fcs;
+  unsigned int value_index;
+  char *buffer;
+  unsigned int buffer_size;
+} yahdlc_bit_decoder_t;
+
+/**
+ * Called for every frame found by @ref yahdlc_bit_get_data. The data is only
+ * valid during the call.
+ *
+ * @param arg Argument given to yahdlc_bit_get_data
+ * @param address Address field of the frame
+ * @param control Control field structure with frame type and sequence number
+ * @param data Frame data
+ * @param data_len Frame data length
+ * @param status 0 on success, -EIO on invalid FCS or length (not a multiple of
+ * 8 bits) or -ENOBUFS if the frame did not fit into the buffer
+ */
+typedef void (*yahdlc_bit_frame_t)(void *arg, unsigned char address,
+                                   const yahdlc_control_t *control,
+                                   const char *data, unsigned int data_len,
+                                   int status);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Builds the lookup tables of the bit-oriented encoder and decoder once. This
+ * is done by yahdlc_bit_encoder_init and yahdlc_bit_decoder_init, so it only
+ * needs to be called to avoid the delay of building them at the first init.
+ * It is safe to call from multiple threads.
+ */
+void yahdlc_bit_init(void);
+
+/**
+ * Initializes the bit-oriented frame encoder and builds the lookup tables if
+ * not done yet (see yahdlc_bit_init)
+ *
+ * @param[out] encoder Encoder
+ */
+void yahdlc_bit_encoder_init(yahdlc_bit_encoder_t *encoder);
+
+/**
+ * Creates a bit-oriented HDLC frame with zero-bit insertion after five
+ * consecutive ones. The bits are sent least significant bit first, and the
+ * bits of the last byte which are not complete are kept in the encoder.
+ *
+ * @param[in] encoder Encoder
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[in] src Source buffer with data
+ * @param[in] src_len Source buffer length
+ * @param[out] dest Destination buffer (should be able to contain 6/5 of the
+ * frame size plus 4 bytes)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_bit_frame_data(yahdlc_bit_encoder_t *encoder,
+                          yahdlc_control_t *control, const char *src,
+                          unsigned int src_len, char *dest,
+                          unsigned int *dest_len);
+
+/**
+ * Writes the bits kept in the encoder padded with ones (idle) to a whole byte
+ *
+ * @param[in] encoder Encoder
+ * @param[out] dest Destination buffer (at least one byte)
+ * @returns Number of bytes written to dest (0 or 1)
+ */
+unsigned int yahdlc_bit_flush(yahdlc_bit_encoder_t *encoder, char *dest);
+
+/**
+ * Initializes the bit-oriented frame decoder and builds the lookup tables if
+ * not done yet (see yahdlc_bit_init)
+ *
+ * @param[out] decoder Decoder
+ * @param[in] buffer Buffer for the frame data
+ * @param[in] buffer_size Buffer size (max frame data size plus FCS size)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_bit_decoder_init(yahdlc_bit_decoder_t *decoder, char *buffer,
+                            unsigned int buffer_size);
+
+/**
+ * Decodes received bit-oriented data. Flag sequences are found at any bit
+ * offset, inserted zero bits are removed and seven or more consecutive ones
+ * abort the current frame. Frames can be received in any number of buffers.
+ *
+ * @param[in] decoder Decoder
+ * @param[in] src Received data
+ * @param[in] src_len Received data length
+ * @param[in] frame Function called for every frame found
+ * @param[in] arg Argument passed to frame
+ * @retval >=0 Number of valid frames found
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_bit_get_data(yahdlc_bit_decoder_t *decoder, const char *src,
+                        unsigned int src_len, yahdlc_bit_frame_t frame,
+                        void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
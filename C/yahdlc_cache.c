@@ -0,0 +1,130 @@
+#include "yahdlc_cache.h"
+#include <string.h>
+
+int yahdlc_cache_init(yahdlc_cache_t *cache, char *buffers,
+                      unsigned int slot_size) {
+  unsigned int i, len;
+  yahdlc_control_t control;
+
+  // Make sure that all parameters are valid
+  if (!cache || !buffers || (slot_size < YAHDLC_CACHE_SLOT_SIZE(0))) {
+    return -EINVAL;
+  }
+
+  memset(cache, 0, sizeof(*cache));
+  cache->buffers = buffers;
+  cache->slot_size = slot_size;
+  cache->window = YAHDLC_CACHE_WINDOW_MAX;
+
+  // Encode the acknowledge frames once, so sending them is only a copy
+  for (i = 0; i < YAHDLC_CACHE_SLOTS; i++) {
+    control.seq_no = i;
+
+    control.frame = YAHDLC_FRAME_ACK;
+    yahdlc_frame_data(&control, NULL, 0, cache->ack[i], &len);
+    cache->ack_length[i] = len;
+
+    control.frame = YAHDLC_FRAME_NACK;
+    yahdlc_frame_data(&control, NULL, 0, cache->nack[i], &len);
+    cache->nack_length[i] = len;
+  }
+
+  return 0;
+}
+
+int yahdlc_cache_set_window(yahdlc_cache_t *cache, unsigned int window) {
+  // Make sure that all parameters are valid
+  if (!cache || !window || (window > YAHDLC_CACHE_WINDOW_MAX)) {
+    return -EINVAL;
+  }
+
+  cache->window = window;
+  return 0;
+}
+
+int yahdlc_cache_frame_data(yahdlc_cache_t *cache, yahdlc_control_t *control,
+                            const char *src, unsigned int src_len,
+                            const char **frame, unsigned int *frame_len) {
+  int ret;
+  unsigned int i, outstanding = 0;
+  char *slot;
+
+  // Make sure that all parameters are valid
+  if (!cache || !cache->buffers || !control
+      || (control->frame != YAHDLC_FRAME_DATA) || !frame || !frame_len) {
+    return -EINVAL;
+  }
+
+  // Check the data size first as the slot size of larger data overflows
+  if ((src_len > YAHDLC_FRAME_DATA_SIZE_MAX)
+      || (YAHDLC_CACHE_SLOT_SIZE(src_len) > cache->slot_size)) {
+    return -ENOBUFS;
+  }
+
+  // A new sequence number is only used while fewer frames than the window
+  // are waiting to be acknowledged
+  if (!cache->length[control->seq_no]) {
+    for (i = 0; i < YAHDLC_CACHE_SLOTS; i++) {
+      outstanding += (cache->length[i] != 0);
+    }
+
+    if (outstanding >= cache->window) {
+      return -EBUSY;
+    }
+  }
+
+  slot = &cache->buffers[control->seq_no * cache->slot_size];
+  ret = yahdlc_frame_data(control, src, src_len, slot,
+                          &cache->length[control->seq_no]);
+  if (ret) {
+    cache->length[control->seq_no] = 0;
+    return ret;
+  }
+
+  *frame = slot;
+  *frame_len = cache->length[control->seq_no];
+  return 0;
+}
+
+int yahdlc_cache_get(yahdlc_cache_t *cache, unsigned int seq_no,
+                     const char **frame, unsigned int *frame_len) {
+  // Make sure that all parameters are valid
+  if (!cache || !cache->buffers || (seq_no >= YAHDLC_CACHE_SLOTS) || !frame
+      || !frame_len) {
+    return -EINVAL;
+  }
+
+  if (!cache->length[seq_no]) {
+    return -ENOMSG;
+  }
+
+  *frame = &cache->buffers[seq_no * cache->slot_size];
+  *frame_len = cache->length[seq_no];
+  return 0;
+}
+
+void yahdlc_cache_release(yahdlc_cache_t *cache, unsigned int seq_no) {
+  if (cache && (seq_no < YAHDLC_CACHE_SLOTS)) {
+    cache->length[seq_no] = 0;
+  }
+}
+
+int yahdlc_cache_s_frame(yahdlc_cache_t *cache, const yahdlc_control_t *control,
+                         const char **frame, unsigned int *frame_len) {
+  // Make sure that all parameters are valid
+  if (!cache || !control || !frame || !frame_len) {
+    return -EINVAL;
+  }
+
+  if (control->frame == YAHDLC_FRAME_ACK) {
+    *frame = cache->ack[control->seq_no];
+    *frame_len = cache->ack_length[control->seq_no];
+  } else if (control->frame == YAHDLC_FRAME_NACK) {
+    *frame = cache->nack[control->seq_no];
+    *frame_len = cache->nack_length[control->seq_no];
+  } else {
+    return -EINVAL;
+  }
+
+  return 0;
+}
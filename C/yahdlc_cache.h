@@ -0,0 +1,135 @@
+/**
+ * @file yahdlc_cache.h
+ */
+
+#ifndef YAHDLC_CACHE_H
+#define YAHDLC_CACHE_H
+
+#include "yahdlc.h"
+
+/** Number of sequence numbers of the 8-bit control field */
+#define YAHDLC_CACHE_SLOTS 8
+
+/** Maximum window size, as with 3-bit sequence numbers (modulo 8) a full
+ * window of 8 frames can not be told apart from an empty one
+ */
+#define YAHDLC_CACHE_WINDOW_MAX (YAHDLC_CACHE_SLOTS - 1)
+
+/** Maximum size of an encoded ACK or NACK frame (flag sequences and escaped
+ * address, control and FCS fields)
+ */
+#define YAHDLC_CACHE_S_FRAME_SIZE_MAX (2 + (2 * (2 + sizeof(FCS_SIZE))))
+
+/** Slot size needed for frames with the given data size (every value escaped,
+ * data size up to YAHDLC_FRAME_DATA_SIZE_MAX)
+ */
+#define YAHDLC_CACHE_SLOT_SIZE(data_size) (2 + (2 * ((data_size) + 2 + sizeof(FCS_SIZE))))
+
+/** Encoded DATA frames kept for retransmission, one slot per sequence number,
+ * and the encoded ACK and NACK frames of every sequence number
+ */
+typedef struct {
+  char *buffers;
+  unsigned int slot_size;
+  unsigned int window;
+  unsigned int length[YAHDLC_CACHE_SLOTS];
+  char ack[YAHDLC_CACHE_SLOTS][YAHDLC_CACHE_S_FRAME_SIZE_MAX];
+  unsigned char ack_length[YAHDLC_CACHE_SLOTS];
+  char nack[YAHDLC_CACHE_SLOTS][YAHDLC_CACHE_S_FRAME_SIZE_MAX];
+  unsigned char nack_length[YAHDLC_CACHE_SLOTS];
+} yahdlc_cache_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes the cache and encodes the ACK and NACK frames of every
+ * sequence number. The window (maximum number of frames kept at the same
+ * time) is YAHDLC_CACHE_WINDOW_MAX until it is changed with
+ * yahdlc_cache_set_window (e.g. by yahdlc_xid_apply).
+ *
+ * @param[out] cache Retransmission cache
+ * @param[in] buffers YAHDLC_CACHE_SLOTS buffers of slot_size bytes
+ * @param[in] slot_size Size of each buffer (see YAHDLC_CACHE_SLOT_SIZE)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_cache_init(yahdlc_cache_t *cache, char *buffers,
+                      unsigned int slot_size);
+
+/**
+ * Sets the window (maximum number of frames kept at the same time). Frames
+ * already kept stay until they are released, even if there are more than
+ * the new window.
+ *
+ * @param[in] cache Retransmission cache
+ * @param[in] window Window size (1 to YAHDLC_CACHE_WINDOW_MAX)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_cache_set_window(yahdlc_cache_t *cache, unsigned int window);
+
+/**
+ * Creates a DATA frame in the slot of its sequence number, replacing the
+ * frame which was kept there. The frame stays valid until the slot is
+ * released or reused.
+ *
+ * @param[in] cache Retransmission cache
+ * @param[in] control Control field structure with DATA frame type and sequence number
+ * @param[in] src Source buffer with data
+ * @param[in] src_len Source buffer length
+ * @param[out] frame Encoded frame
+ * @param[out] frame_len Encoded frame length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or not a DATA frame
+ * @retval -ENOBUFS Data too large for the slot size
+ * @retval -EBUSY Window full (wait until a kept frame is released)
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_cache_frame_data(yahdlc_cache_t *cache, yahdlc_control_t *control,
+                            const char *src, unsigned int src_len,
+                            const char **frame, unsigned int *frame_len);
+
+/**
+ * Gets the kept DATA frame of a sequence number for retransmission (e.g.
+ * when a NACK is received or on timeout)
+ *
+ * @param[in] cache Retransmission cache
+ * @param[in] seq_no Sequence number
+ * @param[out] frame Encoded frame
+ * @param[out] frame_len Encoded frame length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOMSG No frame kept for the sequence number
+ */
+int yahdlc_cache_get(yahdlc_cache_t *cache, unsigned int seq_no,
+                     const char **frame, unsigned int *frame_len);
+
+/**
+ * Releases the slot of an acknowledged DATA frame
+ *
+ * @param[in] cache Retransmission cache
+ * @param[in] seq_no Sequence number
+ */
+void yahdlc_cache_release(yahdlc_cache_t *cache, unsigned int seq_no);
+
+/**
+ * Gets the encoded ACK or NACK frame of a sequence number
+ *
+ * @param[in] cache Retransmission cache
+ * @param[in] control Control field structure with ACK or NACK frame type and sequence number
+ * @param[out] frame Encoded frame
+ * @param[out] frame_len Encoded frame length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or not an ACK or NACK frame
+ */
+int yahdlc_cache_s_frame(yahdlc_cache_t *cache, const yahdlc_control_t *control,
+                         const char **frame, unsigned int *frame_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,319 @@
+#include "yahdlc_capture.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char yahdlc_capture_magic[4] = { 'Y', 'H', 'D', 'C' };
+
+// All multi-byte values in the files are stored in little-endian byte order
+static void yahdlc_capture_put(unsigned char *dest, unsigned long long value,
+                               unsigned int size) {
+  unsigned int i;
+
+  for (i = 0; i < size; i++) {
+    dest[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+static unsigned long long yahdlc_capture_get(const unsigned char *src,
+                                             unsigned int size) {
+  unsigned int i;
+  unsigned long long value = 0;
+
+  for (i = 0; i < size; i++) {
+    value |= ((unsigned long long) src[i]) << (8 * i);
+  }
+
+  return value;
+}
+
+static char *yahdlc_capture_index_path(const char *path) {
+  char *index_path = malloc(strlen(path) + sizeof(YAHDLC_CAPTURE_INDEX_SUFFIX));
+
+  if (index_path) {
+    strcpy(index_path, path);
+    strcat(index_path, YAHDLC_CAPTURE_INDEX_SUFFIX);
+  }
+
+  return index_path;
+}
+
+int yahdlc_capture_writer_open(yahdlc_capture_writer_t *writer,
+                               const char *path) {
+  int ret;
+  char *index_path;
+  unsigned char header[YAHDLC_CAPTURE_HEADER_SIZE] = { 0 };
+
+  // Make sure that all parameters are valid
+  if (!writer || !path) {
+    return -EINVAL;
+  }
+
+  index_path = yahdlc_capture_index_path(path);
+  if (!index_path) {
+    return -ENOMEM;
+  }
+
+  memset(writer, 0, sizeof(*writer));
+  writer->data = fopen(path, "wb");
+  if (!writer->data) {
+    ret = -errno;
+    free(index_path);
+    return ret;
+  }
+
+  // Remove the created data file again so no capture without index is left
+  writer->index = fopen(index_path, "wb");
+  if (!writer->index) {
+    ret = -errno;
+    yahdlc_capture_writer_close(writer);
+    remove(path);
+    free(index_path);
+    return ret;
+  }
+  free(index_path);
+
+  memcpy(header, yahdlc_capture_magic, sizeof(yahdlc_capture_magic));
+  header[sizeof(yahdlc_capture_magic)] = YAHDLC_CAPTURE_VERSION;
+  if (fwrite(header, sizeof(header), 1, writer->data) != 1) {
+    yahdlc_capture_writer_close(writer);
+    return -EIO;
+  }
+
+  writer->offset = sizeof(header);
+  return 0;
+}
+
+int yahdlc_capture_append(yahdlc_capture_writer_t *writer,
+                          unsigned long long timestamp, unsigned char address,
+                          const yahdlc_control_t *control, const char *data,
+                          unsigned int data_len) {
+  unsigned char record[YAHDLC_CAPTURE_RECORD_SIZE] = { 0 };
+  unsigned char entry[YAHDLC_CAPTURE_INDEX_ENTRY_SIZE];
+
+  // Make sure that all parameters are valid
+  if (!writer || !writer->data || !control || (!data && (data_len > 0))) {
+    return -EINVAL;
+  }
+
+  // The offset no longer matches the files after a partial write
+  if (writer->failed) {
+    return -EIO;
+  }
+
+  // Record header: timestamp, data length, address and control field
+  yahdlc_capture_put(&record[0], timestamp, 8);
+  yahdlc_capture_put(&record[8], data_len, 4);
+  record[12] = address;
+  record[13] = (control->frame << 3) | control->seq_no;
+
+  // Index entry: record offset and timestamp
+  yahdlc_capture_put(&entry[0], writer->offset, 8);
+  yahdlc_capture_put(&entry[8], timestamp, 8);
+
+  if ((fwrite(record, sizeof(record), 1, writer->data) != 1)
+      || (data_len && (fwrite(data, data_len, 1, writer->data) != 1))
+      || (fwrite(entry, sizeof(entry), 1, writer->index) != 1)) {
+    writer->failed = 1;
+    return -EIO;
+  }
+
+  writer->offset += sizeof(record) + data_len;
+  return 0;
+}
+
+int yahdlc_capture_get_data(yahdlc_capture_writer_t *writer,
+                            unsigned long long timestamp,
+                            yahdlc_state_t *state, yahdlc_control_t *control,
+                            const char *src, unsigned int src_len, char *dest,
+                            unsigned int *dest_len) {
+  int ret;
+
+  ret = yahdlc_get_data_with_state(state, control, src, src_len, dest,
+                                   dest_len);
+  if ((ret >= 0)
+      && yahdlc_capture_append(writer, timestamp, state->address, control,
+                               dest, *dest_len)) {
+    *dest_len = ret;
+    ret = -EIO;
+  }
+
+  return ret;
+}
+
+int yahdlc_capture_writer_close(yahdlc_capture_writer_t *writer) {
+  int ret = 0;
+
+  if (!writer) {
+    return -EINVAL;
+  }
+
+  if (writer->data && fclose(writer->data)) {
+    ret = -EIO;
+  }
+
+  if (writer->index && fclose(writer->index)) {
+    ret = -EIO;
+  }
+
+  writer->data = writer->index = NULL;
+  return ret;
+}
+
+static int yahdlc_capture_map(const char *path, const unsigned char **data,
+                              size_t *size) {
+  int fd;
+  void *map;
+  struct stat st;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  if (fstat(fd, &st)) {
+    close(fd);
+    return -errno;
+  }
+
+  *data = NULL;
+  *size = st.st_size;
+
+  // Empty files can not be mapped
+  if (*size) {
+    map = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      close(fd);
+      return -errno;
+    }
+    *data = map;
+  }
+
+  close(fd);
+  return 0;
+}
+
+int yahdlc_capture_reader_open(yahdlc_capture_reader_t *reader,
+                               const char *path) {
+  int ret;
+  char *index_path;
+
+  // Make sure that all parameters are valid
+  if (!reader || !path) {
+    return -EINVAL;
+  }
+
+  memset(reader, 0, sizeof(*reader));
+
+  index_path = yahdlc_capture_index_path(path);
+  if (!index_path) {
+    return -ENOMEM;
+  }
+
+  ret = yahdlc_capture_map(path, &reader->data, &reader->data_size);
+  if (!ret) {
+    ret = yahdlc_capture_map(index_path, &reader->index, &reader->index_size);
+  }
+  free(index_path);
+
+  // Check the file header
+  if (!ret && ((reader->data_size < YAHDLC_CAPTURE_HEADER_SIZE)
+      || memcmp(reader->data, yahdlc_capture_magic, sizeof(yahdlc_capture_magic))
+      || (reader->data[sizeof(yahdlc_capture_magic)] != YAHDLC_CAPTURE_VERSION))) {
+    ret = -EINVAL;
+  }
+
+  if (ret) {
+    yahdlc_capture_reader_close(reader);
+    return ret;
+  }
+
+  reader->frames = reader->index_size / YAHDLC_CAPTURE_INDEX_ENTRY_SIZE;
+  return 0;
+}
+
+int yahdlc_capture_read(const yahdlc_capture_reader_t *reader, size_t frame,
+                        yahdlc_capture_record_t *record) {
+  unsigned long long offset;
+  const unsigned char *header;
+
+  // Make sure that all parameters are valid
+  if (!reader || !record) {
+    return -EINVAL;
+  }
+
+  if (frame >= reader->frames) {
+    return -ENOMSG;
+  }
+
+  offset = yahdlc_capture_get(
+      &reader->index[frame * YAHDLC_CAPTURE_INDEX_ENTRY_SIZE], 8);
+  if ((reader->data_size < YAHDLC_CAPTURE_RECORD_SIZE)
+      || (offset > (reader->data_size - YAHDLC_CAPTURE_RECORD_SIZE))) {
+    return -EINVAL;
+  }
+
+  header = &reader->data[offset];
+  record->timestamp = yahdlc_capture_get(&header[0], 8);
+  record->length = yahdlc_capture_get(&header[8], 4);
+  record->address = header[12];
+  record->control.frame = (yahdlc_frame_t) (header[13] >> 3);
+  record->control.seq_no = header[13] & 0x7;
+  record->data = (const char *) &header[YAHDLC_CAPTURE_RECORD_SIZE];
+
+  if (record->length
+      > (reader->data_size - offset - YAHDLC_CAPTURE_RECORD_SIZE)) {
+    return -EINVAL;
+  }
+
+  return 0;
+}
+
+long yahdlc_capture_find(const yahdlc_capture_reader_t *reader,
+                         unsigned long long timestamp) {
+  size_t low = 0, high, middle;
+
+  // Make sure that all parameters are valid
+  if (!reader) {
+    return -EINVAL;
+  }
+
+  // Binary search for the first index entry with a timestamp not before the
+  // specified timestamp
+  high = reader->frames;
+  while (low < high) {
+    middle = low + ((high - low) / 2);
+    if (yahdlc_capture_get(
+        &reader->index[(middle * YAHDLC_CAPTURE_INDEX_ENTRY_SIZE) + 8], 8)
+        < timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  if (low >= reader->frames) {
+    return -ENOMSG;
+  }
+
+  return low;
+}
+
+void yahdlc_capture_reader_close(yahdlc_capture_reader_t *reader) {
+  if (!reader) {
+    return;
+  }
+
+  if (reader->data) {
+    munmap((void *) reader->data, reader->data_size);
+  }
+
+  if (reader->index) {
+    munmap((void *) reader->index, reader->index_size);
+  }
+
+  memset(reader, 0, sizeof(*reader));
+}
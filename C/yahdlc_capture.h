@@ -0,0 +1,165 @@
+/**
+ * @file yahdlc_capture.h
+ */
+
+#ifndef YAHDLC_CAPTURE_H
+#define YAHDLC_CAPTURE_H
+
+#include "yahdlc.h"
+#include <stddef.h>
+#include <stdio.h>
+
+/** Capture file format version */
+#define YAHDLC_CAPTURE_VERSION 1
+
+/** Size of the capture file header (magic "YHDC", version and reserved bytes) */
+#define YAHDLC_CAPTURE_HEADER_SIZE 8
+
+/** Size of the header in front of the data of each captured frame */
+#define YAHDLC_CAPTURE_RECORD_SIZE 16
+
+/** Size of each entry in the index file (record offset and timestamp) */
+#define YAHDLC_CAPTURE_INDEX_ENTRY_SIZE 16
+
+/** Suffix appended to the capture file path to get the index file path */
+#define YAHDLC_CAPTURE_INDEX_SUFFIX ".idx"
+
+/** Streaming appender writing a capture file and its index file */
+typedef struct {
+  FILE *data;
+  FILE *index;
+  unsigned long long offset;
+  int failed;
+} yahdlc_capture_writer_t;
+
+/** Memory-mapped capture file and index file */
+typedef struct {
+  const unsigned char *data;
+  size_t data_size;
+  const unsigned char *index;
+  size_t index_size;
+  size_t frames;
+} yahdlc_capture_reader_t;
+
+/** A single captured frame. The data points directly into the mapped file. */
+typedef struct {
+  unsigned long long timestamp;
+  yahdlc_control_t control;
+  unsigned char address;
+  const char *data;
+  unsigned int length;
+} yahdlc_capture_record_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates a capture file and the index file next to it (path with
+ * YAHDLC_CAPTURE_INDEX_SUFFIX appended). Existing files are truncated.
+ *
+ * @param[out] writer Capture writer to be initialized
+ * @param[in] path Path of the capture file
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval <0 Negative errno value from creating the files
+ */
+int yahdlc_capture_writer_open(yahdlc_capture_writer_t *writer,
+                               const char *path);
+
+/**
+ * Appends a frame to the capture file and its index. Timestamps must be
+ * non-decreasing for yahdlc_capture_find to work. After a write error the
+ * files may hold a partial record, so all further appends fail with -EIO.
+ *
+ * @param[in] writer Capture writer
+ * @param[in] timestamp Timestamp of the frame (unit defined by the application)
+ * @param[in] address Address field of the frame
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[in] data Frame data
+ * @param[in] data_len Frame data length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -EIO Write error (now or in an earlier append)
+ */
+int yahdlc_capture_append(yahdlc_capture_writer_t *writer,
+                          unsigned long long timestamp, unsigned char address,
+                          const yahdlc_control_t *control, const char *data,
+                          unsigned int data_len);
+
+/**
+ * This is a variation of @ref yahdlc_get_data_with_state which also appends
+ * every successfully decoded frame to the capture file.
+ *
+ * @param[in] writer Capture writer
+ * @param[in] timestamp Timestamp to store with a decoded frame
+ * @retval -EIO Invalid FCS or write error
+ *
+ * @see yahdlc_get_data_with_state
+ */
+int yahdlc_capture_get_data(yahdlc_capture_writer_t *writer,
+                            unsigned long long timestamp,
+                            yahdlc_state_t *state, yahdlc_control_t *control,
+                            const char *src, unsigned int src_len, char *dest,
+                            unsigned int *dest_len);
+
+/**
+ * Flushes and closes the capture file and index file
+ *
+ * @param[in] writer Capture writer
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -EIO Write error
+ */
+int yahdlc_capture_writer_close(yahdlc_capture_writer_t *writer);
+
+/**
+ * Memory maps a capture file and its index file for random access
+ *
+ * @param[out] reader Capture reader to be initialized
+ * @param[in] path Path of the capture file
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or file format
+ * @retval <0 Negative errno value from opening or mapping the files
+ */
+int yahdlc_capture_reader_open(yahdlc_capture_reader_t *reader,
+                               const char *path);
+
+/**
+ * Gets a captured frame by its number in O(1) using the index
+ *
+ * @param[in] reader Capture reader
+ * @param[in] frame Frame number (starting from 0)
+ * @param[out] record Captured frame
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or corrupt file
+ * @retval -ENOMSG No such frame
+ */
+int yahdlc_capture_read(const yahdlc_capture_reader_t *reader, size_t frame,
+                        yahdlc_capture_record_t *record);
+
+/**
+ * Finds the number of the first frame with a timestamp equal to or later
+ * than the specified timestamp (binary search in the index)
+ *
+ * @param[in] reader Capture reader
+ * @param[in] timestamp Timestamp to search for
+ * @retval >=0 Frame number
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOMSG No frame at or after the timestamp
+ */
+long yahdlc_capture_find(const yahdlc_capture_reader_t *reader,
+                         unsigned long long timestamp);
+
+/**
+ * Unmaps the capture file and index file
+ *
+ * @param[in] reader Capture reader
+ */
+void yahdlc_capture_reader_close(yahdlc_capture_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
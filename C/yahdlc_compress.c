@@ -0,0 +1,323 @@
+#include "yahdlc_compress.h"
+#include <string.h>
+
+// Compressed data is a sequence of tokens. A token byte below 0x80 is followed
+// by (value + 1) literal bytes. A token byte with the high bit set is a match
+// of ((value & 0x7F) + 3) bytes followed by the 16-bit little-endian distance
+// minus one back into the dictionary and the already decompressed data.
+#define YAHDLC_COMPRESS_MATCH 0x80
+#define YAHDLC_COMPRESS_MIN_MATCH 3
+#define YAHDLC_COMPRESS_MAX_MATCH (0x7F + YAHDLC_COMPRESS_MIN_MATCH)
+#define YAHDLC_COMPRESS_MAX_LITERALS 0x80
+
+static unsigned char yahdlc_compress_byte(const yahdlc_compress_t *ctx,
+                                          const unsigned char *src,
+                                          unsigned int index) {
+  // The dictionary and the source data are treated as one continuous buffer
+  if (index < ctx->window_len) {
+    return ctx->window[index];
+  }
+
+  return src[index - ctx->window_len];
+}
+
+static unsigned int yahdlc_compress_hash(const yahdlc_compress_t *ctx,
+                                         const unsigned char *src,
+                                         unsigned int index) {
+  unsigned int value = (yahdlc_compress_byte(ctx, src, index) << 16)
+      | (yahdlc_compress_byte(ctx, src, index + 1) << 8)
+      | yahdlc_compress_byte(ctx, src, index + 2);
+
+  return ((value * 2654435761U) >> 24) % YAHDLC_COMPRESS_HASH_SIZE;
+}
+
+static int yahdlc_compress_literals(const unsigned char *src,
+                                    unsigned int len, unsigned char *dest,
+                                    unsigned int *dest_index,
+                                    unsigned int dest_len) {
+  unsigned int run;
+
+  while (len) {
+    run = (len < YAHDLC_COMPRESS_MAX_LITERALS) ? len : YAHDLC_COMPRESS_MAX_LITERALS;
+    if ((*dest_index + 1 + run) > dest_len) {
+      return -1;
+    }
+
+    dest[(*dest_index)++] = run - 1;
+    memcpy(&dest[*dest_index], src, run);
+    *dest_index += run;
+    src += run;
+    len -= run;
+  }
+
+  return 0;
+}
+
+// Returns the compressed length or 0 if the data could not be compressed into
+// less than dest_len bytes
+static unsigned int yahdlc_compress(yahdlc_compress_t *ctx,
+                                    const unsigned char *src,
+                                    unsigned int src_len, unsigned char *dest,
+                                    unsigned int dest_len) {
+  unsigned int i, hash, match, match_len, literals, dest_index = 0;
+  unsigned int total_len = ctx->window_len + src_len;
+  unsigned int index = ctx->window_len;
+
+  // Add all positions in the dictionary to the match finder
+  memset(ctx->hash, 0, sizeof(ctx->hash));
+  for (i = 0; (i + YAHDLC_COMPRESS_MIN_MATCH) <= ctx->window_len; i++) {
+    ctx->hash[yahdlc_compress_hash(ctx, src, i)] = i + 1;
+  }
+
+  literals = index;
+  while (index < total_len) {
+    match_len = 0;
+
+    if ((index + YAHDLC_COMPRESS_MIN_MATCH) <= total_len) {
+      hash = yahdlc_compress_hash(ctx, src, index);
+      match = ctx->hash[hash];
+      ctx->hash[hash] = index + 1;
+
+      // Positions are stored incremented by one so zero means an empty entry
+      if (match--) {
+        while (((index + match_len) < total_len)
+            && (match_len < YAHDLC_COMPRESS_MAX_MATCH)
+            && (yahdlc_compress_byte(ctx, src, match + match_len)
+                == yahdlc_compress_byte(ctx, src, index + match_len))) {
+          match_len++;
+        }
+      }
+    }
+
+    if (match_len < YAHDLC_COMPRESS_MIN_MATCH) {
+      index++;
+      continue;
+    }
+
+    // Write the pending literals followed by the match
+    if (yahdlc_compress_literals(&src[literals - ctx->window_len],
+                                 index - literals, dest, &dest_index, dest_len)
+        || ((dest_index + 3) > dest_len)) {
+      return 0;
+    }
+
+    dest[dest_index++] = YAHDLC_COMPRESS_MATCH | (match_len - YAHDLC_COMPRESS_MIN_MATCH);
+    dest[dest_index++] = (index - match - 1) & 0xFF;
+    dest[dest_index++] = (index - match - 1) >> 8;
+
+    for (i = 1; i < match_len; i++) {
+      if ((index + i + YAHDLC_COMPRESS_MIN_MATCH) <= total_len) {
+        ctx->hash[yahdlc_compress_hash(ctx, src, index + i)] = index + i + 1;
+      }
+    }
+
+    index += match_len;
+    literals = index;
+  }
+
+  if (yahdlc_compress_literals(&src[literals - ctx->window_len],
+                               index - literals, dest, &dest_index, dest_len)) {
+    return 0;
+  }
+
+  return dest_index;
+}
+
+// Returns the decompressed length or -1 if the compressed data is invalid
+static int yahdlc_decompress(const yahdlc_compress_t *ctx,
+                             const unsigned char *src, unsigned int src_len,
+                             unsigned char *dest, unsigned int dest_len) {
+  unsigned int len, distance, index, src_index = 0, dest_index = 0;
+
+  while (src_index < src_len) {
+    len = src[src_index++];
+
+    if (len & YAHDLC_COMPRESS_MATCH) {
+      len = (len & ~YAHDLC_COMPRESS_MATCH) + YAHDLC_COMPRESS_MIN_MATCH;
+      if ((src_index + 2) > src_len) {
+        return -1;
+      }
+
+      distance = (src[src_index] | (src[src_index + 1] << 8)) + 1;
+      src_index += 2;
+      if ((distance > (ctx->window_len + dest_index))
+          || ((dest_index + len) > dest_len)) {
+        return -1;
+      }
+
+      // Copy byte by byte as the match may overlap the bytes being written
+      while (len--) {
+        index = ctx->window_len + dest_index - distance;
+        dest[dest_index++] = (index < ctx->window_len) ?
+            ctx->window[index] : dest[index - ctx->window_len];
+      }
+    } else {
+      len++;
+      if (((src_index + len) > src_len) || ((dest_index + len) > dest_len)) {
+        return -1;
+      }
+
+      memcpy(&dest[dest_index], &src[src_index], len);
+      src_index += len;
+      dest_index += len;
+    }
+  }
+
+  return dest_index;
+}
+
+static void yahdlc_compress_update(yahdlc_compress_t *ctx,
+                                   const char *data, unsigned int len) {
+  unsigned int keep;
+
+  // Keep the last YAHDLC_COMPRESS_WINDOW bytes of data as dictionary
+  if (len >= YAHDLC_COMPRESS_WINDOW) {
+    memcpy(ctx->window, &data[len - YAHDLC_COMPRESS_WINDOW], YAHDLC_COMPRESS_WINDOW);
+    ctx->window_len = YAHDLC_COMPRESS_WINDOW;
+  } else {
+    keep = YAHDLC_COMPRESS_WINDOW - len;
+    if (ctx->window_len > keep) {
+      memmove(ctx->window, &ctx->window[ctx->window_len - keep], keep);
+      ctx->window_len = keep;
+    }
+    memcpy(&ctx->window[ctx->window_len], data, len);
+    ctx->window_len += len;
+  }
+
+  ctx->seq_no = (ctx->seq_no + 1) & YAHDLC_COMPRESS_SEQ_MASK;
+  ctx->reset = 0;
+}
+
+void yahdlc_compress_reset(yahdlc_compress_t *ctx) {
+  ctx->window_len = 0;
+  ctx->seq_no = 0;
+  ctx->reset = 1;
+}
+
+int yahdlc_compress_frame_data(yahdlc_compress_t *ctx,
+                               yahdlc_control_t *control, const char *src,
+                               unsigned int src_len, char *dest,
+                               unsigned int *dest_len) {
+  int ret;
+  unsigned int len;
+
+  // Make sure that all parameters are valid
+  if (!ctx || !control || (!src && (src_len > 0))
+      || (src_len > YAHDLC_COMPRESS_MAX_DATA)) {
+    return -EINVAL;
+  }
+
+  // Only the data of DATA frames is compressed
+  if (control->frame != YAHDLC_FRAME_DATA) {
+    return yahdlc_frame_data(control, src, src_len, dest, dest_len);
+  }
+
+  ctx->buffer[0] = ctx->seq_no;
+  if (ctx->reset) {
+    ctx->buffer[0] |= YAHDLC_COMPRESS_RESET;
+  }
+
+  // Only use the compressed data if it is smaller than the data itself
+  len = yahdlc_compress(ctx, (const unsigned char *) src, src_len,
+                        (unsigned char *) &ctx->buffer[1], src_len);
+  if (len) {
+    ctx->buffer[0] |= YAHDLC_COMPRESS_FLAG;
+  } else {
+    len = src_len;
+    if (len) {
+      memcpy(&ctx->buffer[1], src, len);
+    }
+  }
+
+  ret = yahdlc_frame_data(control, ctx->buffer, len + 1, dest, dest_len);
+  if (!ret) {
+    yahdlc_compress_update(ctx, src, src_len);
+  }
+
+  return ret;
+}
+
+int yahdlc_compress_get_data(yahdlc_compress_t *ctx, yahdlc_state_t *state,
+                             yahdlc_control_t *control, const char *src,
+                             unsigned int src_len, char *dest,
+                             unsigned int *dest_len) {
+  int ret, len;
+  unsigned int offset = 0, room;
+  unsigned char header;
+
+  // Make sure that all parameters are valid
+  if (!ctx || !state || !src || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  for (;;) {
+    // Never pass more values than the buffer has room for
+    room = sizeof(ctx->buffer) - state->dest_index;
+    if (room > (src_len - offset)) {
+      room = src_len - offset;
+    }
+
+    ret = yahdlc_get_data_with_state(state, control, &src[offset], room,
+                                     ctx->buffer, dest_len);
+    if (ret >= 0) {
+      ret += offset;
+      break;
+    } else if (ret == -EIO) {
+      *dest_len += offset;
+      return ret;
+    } else if (ret != -ENOMSG) {
+      return ret;
+    }
+
+    offset += room;
+    if (state->dest_index >= (int) sizeof(ctx->buffer)) {
+      // Drop the frame and wait for the next flag sequence
+      yahdlc_get_data_reset_with_state(state);
+      *dest_len = offset;
+      return -ENOBUFS;
+    } else if (offset >= src_len) {
+      return ret;
+    }
+  }
+
+  // The data of other frames (e.g. XID) is not compressed
+  if (control->frame != YAHDLC_FRAME_DATA) {
+    if (*dest_len > YAHDLC_COMPRESS_MAX_DATA) {
+      *dest_len = ret;
+      return -ENOBUFS;
+    }
+
+    memcpy(dest, ctx->buffer, *dest_len);
+    return ret;
+  }
+
+  header = (*dest_len > 0) ? ctx->buffer[0] : 0;
+  if (header & YAHDLC_COMPRESS_RESET) {
+    yahdlc_compress_reset(ctx);
+    ctx->seq_no = header & YAHDLC_COMPRESS_SEQ_MASK;
+  }
+
+  // Check that the frame is in sequence with the dictionary
+  if (!*dest_len || ((header & YAHDLC_COMPRESS_SEQ_MASK) != ctx->seq_no)) {
+    len = -1;
+  } else if (header & YAHDLC_COMPRESS_FLAG) {
+    len = yahdlc_decompress(ctx, (const unsigned char *) &ctx->buffer[1],
+                            *dest_len - 1, (unsigned char *) dest,
+                            YAHDLC_COMPRESS_MAX_DATA);
+  } else if ((*dest_len - 1) <= YAHDLC_COMPRESS_MAX_DATA) {
+    len = *dest_len - 1;
+    memcpy(dest, &ctx->buffer[1], len);
+  } else {
+    len = -1;
+  }
+
+  if (len < 0) {
+    // Indicate that data up to end flag sequence in buffer should be discarded
+    *dest_len = ret;
+    return -EIO;
+  }
+
+  yahdlc_compress_update(ctx, dest, len);
+  *dest_len = len;
+  return ret;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file yahdlc_compress.h
+ */
+
+#ifndef YAHDLC_COMPRESS_H
+#define YAHDLC_COMPRESS_H
+
+#include "yahdlc.h"
+
+/** Size of the dictionary (history of previous frames) kept per link */
+#ifndef YAHDLC_COMPRESS_WINDOW
+#define YAHDLC_COMPRESS_WINDOW 512
+#endif
+
+/** Maximum size of the uncompressed data in a frame */
+#ifndef YAHDLC_COMPRESS_MAX_DATA
+#define YAHDLC_COMPRESS_MAX_DATA 512
+#endif
+
+/** Number of entries in the match finder hash table */
+#define YAHDLC_COMPRESS_HASH_SIZE 256
+
+/** Header byte flag indicating that the data is compressed */
+#define YAHDLC_COMPRESS_FLAG 0x80
+
+/** Header byte flag indicating that the dictionary has been reset */
+#define YAHDLC_COMPRESS_RESET 0x40
+
+/** Header byte mask of the dictionary sequence number */
+#define YAHDLC_COMPRESS_SEQ_MASK 0x3F
+
+#if (YAHDLC_COMPRESS_WINDOW + YAHDLC_COMPRESS_MAX_DATA) > 0xFFFF
+#error "Sum of YAHDLC_COMPRESS_WINDOW and YAHDLC_COMPRESS_MAX_DATA must be below 64 KiB"
+#endif
+
+/** Compression context for one direction of a link. The dictionary is made of
+ * the data of the previous frames, so both ends must see the same frames in
+ * the same order.
+ */
+typedef struct {
+  unsigned char window[YAHDLC_COMPRESS_WINDOW];
+  unsigned int window_len;
+  unsigned char seq_no;
+  char reset;
+  unsigned short hash[YAHDLC_COMPRESS_HASH_SIZE];
+  // Header, data and FCS plus one spare byte to detect frames that are too large
+  char buffer[1 + YAHDLC_COMPRESS_MAX_DATA + sizeof(FCS_SIZE) + 1];
+} yahdlc_compress_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Resets the dictionary. When used for sending, the next DATA frame signals
+ * the receiver to reset its dictionary as well. This should be done when
+ * frames have been lost or retransmitted (e.g. on NACK or timeout).
+ *
+ * @param[in] ctx Compression context
+ */
+void yahdlc_compress_reset(yahdlc_compress_t *ctx);
+
+/**
+ * This is a variation of @ref yahdlc_frame_data which compresses the data of
+ * DATA frames before framing. A one-byte header is put in front of the data
+ * indicating if the data is compressed. Data that does not compress is sent
+ * uncompressed.
+ *
+ * @param[in] ctx Compression context of the sending direction
+ * @retval -EINVAL Invalid parameter or src_len above YAHDLC_COMPRESS_MAX_DATA
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_compress_frame_data(yahdlc_compress_t *ctx,
+                               yahdlc_control_t *control, const char *src,
+                               unsigned int src_len, char *dest,
+                               unsigned int *dest_len);
+
+/**
+ * This is a variation of @ref yahdlc_get_data_with_state which decompresses
+ * the data of DATA frames created with @ref yahdlc_compress_frame_data. The
+ * data of other frames (e.g. XID) is returned unchanged.
+ *
+ * @param[in] ctx Compression context of the receiving direction
+ * @param[out] dest Destination buffer (should be able to contain YAHDLC_COMPRESS_MAX_DATA)
+ * @retval -EIO Invalid FCS, or the dictionary is out of sync or the data is
+ * invalid (size of dest_len should be discarded from source buffer)
+ * @retval -ENOBUFS Frame too large for the context, which is dropped (size of
+ * dest_len should be discarded from source buffer)
+ *
+ * @see yahdlc_get_data_with_state
+ */
+int yahdlc_compress_get_data(yahdlc_compress_t *ctx, yahdlc_state_t *state,
+                             yahdlc_control_t *control, const char *src,
+                             unsigned int src_len, char *dest,
+                             unsigned int *dest_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,292 @@
+#include "yahdlc_fragment.h"
+#include <string.h>
+
+int yahdlc_fragment_tx_init(yahdlc_fragment_tx_t *tx,
+                            unsigned int fragment_size) {
+  // Make sure that all parameters are valid
+  if (!tx || !fragment_size || (fragment_size > YAHDLC_FRAGMENT_SIZE_MAX)) {
+    return -EINVAL;
+  }
+
+  memset(tx, 0, sizeof(*tx));
+  tx->fragment_size = fragment_size;
+  return 0;
+}
+
+static unsigned int yahdlc_fragment_count(unsigned int msg_len,
+                                          unsigned int fragment_size) {
+  // Empty messages are sent as a single empty fragment
+  return msg_len ? (((msg_len - 1) / fragment_size) + 1) : 1;
+}
+
+int yahdlc_fragment_tx_begin(yahdlc_fragment_tx_t *tx, const char *msg,
+                             unsigned int msg_len) {
+  unsigned int fragments;
+
+  // Make sure that all parameters are valid
+  if (!tx || !tx->fragment_size || (!msg && (msg_len > 0))) {
+    return -EINVAL;
+  }
+
+  fragments = yahdlc_fragment_count(msg_len, tx->fragment_size);
+  if (fragments > YAHDLC_FRAGMENT_MAX_FRAGMENTS) {
+    return -EINVAL;
+  }
+
+  // Use a new message id so the receiver does not mix up the messages
+  tx->msg_id++;
+  tx->msg = msg;
+  tx->msg_len = msg_len;
+  return fragments;
+}
+
+int yahdlc_fragment_frame_data(yahdlc_fragment_tx_t *tx,
+                               yahdlc_control_t *control, unsigned int index,
+                               char *dest, unsigned int *dest_len) {
+  unsigned int fragments, offset, len, header, frame_len, dest_index;
+  char fragment_header[YAHDLC_FRAGMENT_HEADER_SIZE];
+  yahdlc_encoder_t encoder;
+
+  // Make sure that all parameters are valid
+  if (!tx || !tx->fragment_size || !control || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  fragments = yahdlc_fragment_count(tx->msg_len, tx->fragment_size);
+  if (index >= fragments) {
+    return -EINVAL;
+  }
+
+  offset = index * tx->fragment_size;
+  len = tx->msg_len - offset;
+  if (len > tx->fragment_size) {
+    len = tx->fragment_size;
+  }
+
+  header = index;
+  if (index == (fragments - 1)) {
+    header |= YAHDLC_FRAGMENT_LAST;
+  }
+
+  // Add the fragment header in front of the fragment data
+  fragment_header[0] = tx->msg_id;
+  fragment_header[1] = header & 0xFF;
+  fragment_header[2] = header >> 8;
+
+  yahdlc_frame_begin(&encoder, YAHDLC_ALL_STATION_ADDR, control, dest, &frame_len);
+  dest_index = frame_len;
+  yahdlc_frame_append(&encoder, fragment_header, sizeof(fragment_header),
+                      &dest[dest_index], &frame_len);
+  dest_index += frame_len;
+  yahdlc_frame_append(&encoder, &tx->msg[offset], len, &dest[dest_index],
+                      &frame_len);
+  dest_index += frame_len;
+  yahdlc_frame_finish(&encoder, &dest[dest_index], &frame_len);
+  *dest_len = dest_index + frame_len;
+
+  return 0;
+}
+
+int yahdlc_fragment_rx_init(yahdlc_fragment_rx_t *rx,
+                            unsigned int fragment_size, unsigned long timeout,
+                            char *buffers, unsigned int buffer_size) {
+  unsigned int i;
+
+  // Make sure that all parameters are valid
+  if (!rx || !fragment_size || !buffers) {
+    return -EINVAL;
+  }
+
+  memset(rx, 0, sizeof(*rx));
+  rx->buffer_size = buffer_size;
+  rx->fragment_size = fragment_size;
+  rx->timeout = timeout;
+
+  for (i = 0; i < YAHDLC_FRAGMENT_MAX_MESSAGES; i++) {
+    rx->slots[i].buffer = &buffers[i * buffer_size];
+  }
+
+  return 0;
+}
+
+int yahdlc_fragment_reset(yahdlc_fragment_tx_t *tx, yahdlc_fragment_rx_t *rx,
+                          unsigned int fragment_size) {
+  unsigned int i;
+
+  // Make sure that all parameters are valid
+  if (!fragment_size || (fragment_size > YAHDLC_FRAGMENT_SIZE_MAX)) {
+    return -EINVAL;
+  }
+
+  if (tx) {
+    tx->msg = NULL;
+    tx->msg_len = 0;
+    tx->fragment_size = fragment_size;
+  }
+
+  if (rx) {
+    for (i = 0; i < YAHDLC_FRAGMENT_MAX_MESSAGES; i++) {
+      rx->slots[i].active = 0;
+    }
+    rx->fragment_size = fragment_size;
+  }
+
+  return 0;
+}
+
+unsigned int yahdlc_fragment_expire(yahdlc_fragment_rx_t *rx,
+                                    unsigned long now) {
+  unsigned int i, expired = 0;
+
+  if (!rx) {
+    return 0;
+  }
+
+  for (i = 0; i < YAHDLC_FRAGMENT_MAX_MESSAGES; i++) {
+    if (rx->slots[i].active && ((now - rx->slots[i].timestamp) > rx->timeout)) {
+      rx->slots[i].active = 0;
+      expired++;
+    }
+  }
+
+  return expired;
+}
+
+static int yahdlc_fragment_completed(const yahdlc_fragment_rx_t *rx,
+                                     unsigned char msg_id) {
+  unsigned int i;
+
+  for (i = 0; i < rx->completed_len; i++) {
+    if (rx->completed[i] == msg_id) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void yahdlc_fragment_complete(yahdlc_fragment_rx_t *rx,
+                                     unsigned char msg_id) {
+  // Replace the oldest completed message id once all are used
+  rx->completed[rx->completed_next] = msg_id;
+  rx->completed_next = (rx->completed_next + 1) % YAHDLC_FRAGMENT_COMPLETED_IDS;
+  if (rx->completed_len < YAHDLC_FRAGMENT_COMPLETED_IDS) {
+    rx->completed_len++;
+  }
+}
+
+static yahdlc_fragment_slot_t *yahdlc_fragment_slot(yahdlc_fragment_rx_t *rx,
+                                                    unsigned char msg_id) {
+  unsigned int i;
+  yahdlc_fragment_slot_t *slot = NULL;
+
+  for (i = 0; i < YAHDLC_FRAGMENT_MAX_MESSAGES; i++) {
+    if (rx->slots[i].active && (rx->slots[i].msg_id == msg_id)) {
+      return &rx->slots[i];
+    } else if (!rx->slots[i].active && !slot) {
+      slot = &rx->slots[i];
+    }
+  }
+
+  // Start reassembly of a new message in a free slot
+  if (slot) {
+    slot->active = 1;
+    slot->msg_id = msg_id;
+    slot->length = slot->received = slot->fragments = slot->highest = 0;
+    memset(slot->bitmap, 0, sizeof(slot->bitmap));
+  }
+
+  return slot;
+}
+
+int yahdlc_fragment_receive(yahdlc_fragment_rx_t *rx, const char *src,
+                            unsigned int src_len, unsigned long now,
+                            char **msg, unsigned int *msg_len) {
+  unsigned int index, fragment, offset, len;
+  unsigned char bit;
+  yahdlc_fragment_slot_t *slot;
+
+  // Make sure that all parameters are valid
+  if (!rx || !src || !msg || !msg_len) {
+    return -EINVAL;
+  }
+
+  if (src_len < YAHDLC_FRAGMENT_HEADER_SIZE) {
+    return -ENOMSG;
+  }
+
+  // All fragments but the last must be full
+  index = (unsigned char) src[1] | ((unsigned char) src[2] << 8);
+  len = src_len - YAHDLC_FRAGMENT_HEADER_SIZE;
+  if ((len > rx->fragment_size)
+      || (!(index & YAHDLC_FRAGMENT_LAST) && (len != rx->fragment_size))) {
+    return -ENOMSG;
+  }
+
+  fragment = index & ~YAHDLC_FRAGMENT_LAST;
+  if (fragment >= YAHDLC_FRAGMENT_MAX_FRAGMENTS) {
+    return -ENOMSG;
+  }
+
+  // Free the slots of timed out messages before looking for a slot
+  yahdlc_fragment_expire(rx, now);
+
+  // Silently ignore fragments of messages which were already delivered, as a
+  // new slot would deliver them again or hold it until the timeout
+  if (yahdlc_fragment_completed(rx, src[0])) {
+    return -EAGAIN;
+  }
+
+  slot = yahdlc_fragment_slot(rx, src[0]);
+  if (!slot) {
+    return -ENOBUFS;
+  }
+
+  slot->timestamp = now;
+  offset = fragment * rx->fragment_size;
+  if ((offset + len) > rx->buffer_size) {
+    slot->active = 0;
+    return -ENOBUFS;
+  }
+
+  if (slot->fragments && (fragment >= slot->fragments)) {
+    return -ENOMSG;
+  }
+
+  // Silently ignore retransmitted fragments
+  bit = 1 << (fragment % 8);
+  if (slot->bitmap[fragment / 8] & bit) {
+    return -EAGAIN;
+  }
+
+  // A last fragment before fragments already received can never complete the
+  // message, so drop it instead of waiting for the timeout
+  if ((index & YAHDLC_FRAGMENT_LAST) && ((fragment + 1) < slot->highest)) {
+    slot->active = 0;
+    return -EIO;
+  }
+
+  if ((fragment + 1) > slot->highest) {
+    slot->highest = fragment + 1;
+  }
+
+  slot->bitmap[fragment / 8] |= bit;
+  memcpy(&slot->buffer[offset], &src[YAHDLC_FRAGMENT_HEADER_SIZE], len);
+  slot->received++;
+
+  if (index & YAHDLC_FRAGMENT_LAST) {
+    slot->fragments = fragment + 1;
+    slot->length = offset + len;
+  }
+
+  if (!slot->fragments || (slot->received != slot->fragments)) {
+    return -EAGAIN;
+  }
+
+  // The message is complete so the slot can be used for the next message
+  slot->active = 0;
+  yahdlc_fragment_complete(rx, slot->msg_id);
+  *msg = slot->buffer;
+  *msg_len = slot->length;
+  return 0;
+}
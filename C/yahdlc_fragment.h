@@ -0,0 +1,202 @@
+/**
+ * @file yahdlc_fragment.h
+ */
+
+#ifndef YAHDLC_FRAGMENT_H
+#define YAHDLC_FRAGMENT_H
+
+#include "yahdlc.h"
+
+/** Maximum data size of a single fragment */
+#ifndef YAHDLC_FRAGMENT_SIZE_MAX
+#define YAHDLC_FRAGMENT_SIZE_MAX 1024
+#endif
+
+/** Maximum number of fragments of a single message */
+#ifndef YAHDLC_FRAGMENT_MAX_FRAGMENTS
+#define YAHDLC_FRAGMENT_MAX_FRAGMENTS 4096
+#endif
+
+/** Maximum number of messages being reassembled at the same time */
+#ifndef YAHDLC_FRAGMENT_MAX_MESSAGES
+#define YAHDLC_FRAGMENT_MAX_MESSAGES 4
+#endif
+
+/** Number of recently completed message ids whose retransmitted fragments
+ * are dropped (must be well below the 256 message ids to not drop new messages)
+ */
+#ifndef YAHDLC_FRAGMENT_COMPLETED_IDS
+#define YAHDLC_FRAGMENT_COMPLETED_IDS 8
+#endif
+
+/** Size of the header in front of each fragment (message id and 16-bit
+ * fragment index with the most significant bit set on the last fragment)
+ */
+#define YAHDLC_FRAGMENT_HEADER_SIZE 3
+
+/** Size of a frame with a fragment of the given data size (every value escaped) */
+#define YAHDLC_FRAGMENT_FRAME_SIZE(fragment_size) \
+  (2 + (2 * ((fragment_size) + YAHDLC_FRAGMENT_HEADER_SIZE + 2 + sizeof(FCS_SIZE))))
+
+/** Fragment index flag marking the last fragment of a message */
+#define YAHDLC_FRAGMENT_LAST 0x8000
+
+#if YAHDLC_FRAGMENT_MAX_FRAGMENTS > YAHDLC_FRAGMENT_LAST
+#error "YAHDLC_FRAGMENT_MAX_FRAGMENTS must not exceed 32768"
+#endif
+
+#if (YAHDLC_FRAGMENT_COMPLETED_IDS < 1) || (YAHDLC_FRAGMENT_COMPLETED_IDS > 128)
+#error "YAHDLC_FRAGMENT_COMPLETED_IDS must be between 1 and 128"
+#endif
+
+/** Segmentation of messages into fragments */
+typedef struct {
+  const char *msg;
+  unsigned int msg_len;
+  unsigned int fragment_size;
+  unsigned char msg_id;
+} yahdlc_fragment_tx_t;
+
+/** Reassembly of a single message */
+typedef struct {
+  char *buffer;
+  unsigned int length;
+  unsigned int received;
+  unsigned int fragments;
+  unsigned int highest;
+  unsigned long timestamp;
+  unsigned char msg_id;
+  char active;
+  unsigned char bitmap[(YAHDLC_FRAGMENT_MAX_FRAGMENTS + 7) / 8];
+} yahdlc_fragment_slot_t;
+
+/** Reassembly of messages into preallocated buffers */
+typedef struct {
+  yahdlc_fragment_slot_t slots[YAHDLC_FRAGMENT_MAX_MESSAGES];
+  unsigned char completed[YAHDLC_FRAGMENT_COMPLETED_IDS];
+  unsigned int completed_len;
+  unsigned int completed_next;
+  unsigned int buffer_size;
+  unsigned int fragment_size;
+  unsigned long timeout;
+} yahdlc_fragment_rx_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes the segmentation of messages
+ *
+ * @param[out] tx Segmentation context
+ * @param[in] fragment_size Data size of each fragment (same as used by the receiver)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_fragment_tx_init(yahdlc_fragment_tx_t *tx,
+                            unsigned int fragment_size);
+
+/**
+ * Starts sending a new message. The message must be kept until all
+ * fragments have been sent and acknowledged.
+ *
+ * @param[in] tx Segmentation context
+ * @param[in] msg Message to be sent
+ * @param[in] msg_len Message length
+ * @retval >0 Number of fragments of the message
+ * @retval -EINVAL Invalid parameter or too many fragments
+ */
+int yahdlc_fragment_tx_begin(yahdlc_fragment_tx_t *tx, const char *msg,
+                             unsigned int msg_len);
+
+/**
+ * Creates a DATA frame with a fragment of the current message. Fragments can
+ * be sent (and retransmitted) in any order.
+ *
+ * @param[in] tx Segmentation context
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[in] index Index of the fragment
+ * @param[out] dest Destination buffer (at least YAHDLC_FRAGMENT_FRAME_SIZE(fragment_size) bytes)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or fragment index
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_fragment_frame_data(yahdlc_fragment_tx_t *tx,
+                               yahdlc_control_t *control, unsigned int index,
+                               char *dest, unsigned int *dest_len);
+
+/**
+ * Initializes the reassembly of messages
+ *
+ * @param[out] rx Reassembly context
+ * @param[in] fragment_size Data size of each fragment (same as used by the sender)
+ * @param[in] timeout Time after the last received fragment at which an
+ * incomplete message is dropped (unit defined by the application)
+ * @param[in] buffers YAHDLC_FRAGMENT_MAX_MESSAGES buffers of buffer_size bytes
+ * @param[in] buffer_size Size of each buffer (maximum message length)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_fragment_rx_init(yahdlc_fragment_rx_t *rx,
+                            unsigned int fragment_size, unsigned long timeout,
+                            char *buffers, unsigned int buffer_size);
+
+/**
+ * Adds a received fragment (data of a DATA frame) to the message it belongs
+ * to. When the message is complete it is returned and stays valid until the
+ * next call to this function. Retransmitted fragments of the last
+ * YAHDLC_FRAGMENT_COMPLETED_IDS completed messages are dropped, so a message
+ * is never delivered twice.
+ *
+ * @param[in] rx Reassembly context
+ * @param[in] src Data of the received frame
+ * @param[in] src_len Data length
+ * @param[in] now Current time (unit defined by the application)
+ * @param[out] msg The reassembled message
+ * @param[out] msg_len The reassembled message length
+ * @retval 0 Success (message complete)
+ * @retval -EINVAL Invalid parameter
+ * @retval -EAGAIN More fragments needed or fragment already received
+ * @retval -ENOMSG Invalid fragment
+ * @retval -EIO Last fragment before fragments already received (the message is dropped)
+ * @retval -ENOBUFS No free buffer or message larger than buffer
+ */
+int yahdlc_fragment_receive(yahdlc_fragment_rx_t *rx, const char *src,
+                            unsigned int src_len, unsigned long now,
+                            char **msg, unsigned int *msg_len);
+
+/**
+ * Changes the fragment size of the segmentation and reassembly contexts (e.g.
+ * after a new maximum information field length was negotiated). As fragments
+ * of different sizes can not be mixed, the message being sent has to be
+ * restarted with yahdlc_fragment_tx_begin and the incomplete received
+ * messages are dropped. Message ids continue, so retransmitted fragments of
+ * already completed messages are still dropped.
+ *
+ * @param[in,out] tx Segmentation context (can be NULL)
+ * @param[in,out] rx Reassembly context (can be NULL)
+ * @param[in] fragment_size New data size of each fragment
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_fragment_reset(yahdlc_fragment_tx_t *tx, yahdlc_fragment_rx_t *rx,
+                          unsigned int fragment_size);
+
+/**
+ * Drops the incomplete messages which have not received any fragment within
+ * the timeout
+ *
+ * @param[in] rx Reassembly context
+ * @param[in] now Current time (unit defined by the application)
+ * @returns Number of dropped messages
+ */
+unsigned int yahdlc_fragment_expire(yahdlc_fragment_rx_t *rx,
+                                    unsigned long now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
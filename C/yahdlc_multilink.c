@@ -0,0 +1,237 @@
+#include "yahdlc_multilink.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Number of chunks of different links decoded interleaved. The FCS of a link
+// is a chain of dependent table lookups, so decoding independent links side by
+// side keeps the CPU busy while a lookup is waiting for memory.
+#define YAHDLC_MULTILINK_LANES 4
+
+// Decoder state of a link held in local variables while its chunk is decoded
+typedef struct {
+  unsigned int link;
+  FCS_SIZE fcs;
+  unsigned int index;
+  unsigned char flags;
+  unsigned char address;
+  unsigned char control;
+  char *buffer;
+  const char *src;
+  unsigned int src_len;
+} yahdlc_multilink_lane_t;
+
+int yahdlc_multilink_init(yahdlc_multilink_t *multilink, unsigned int links,
+                          unsigned int buffer_size) {
+  unsigned int i;
+
+  // Make sure that all parameters are valid (the value index must fit into 16 bits)
+  if (!multilink || !links || (links > YAHDLC_MULTILINK_MAX_LINKS)
+      || ((buffer_size + 2 + sizeof(FCS_SIZE)) > 0xFFFF)) {
+    return -EINVAL;
+  }
+
+  memset(multilink, 0, sizeof(*multilink));
+  multilink->links = links;
+  multilink->buffer_size = buffer_size;
+  multilink->fcs = malloc(links * sizeof(FCS_SIZE));
+  multilink->index = malloc(links * sizeof(unsigned short));
+  multilink->flags = malloc(links);
+  multilink->address = malloc(links);
+  multilink->control = malloc(links);
+  multilink->buffers = malloc(links * (buffer_size + sizeof(FCS_SIZE)));
+  if (!multilink->fcs || !multilink->index || !multilink->flags
+      || !multilink->address || !multilink->control || !multilink->buffers) {
+    yahdlc_multilink_free(multilink);
+    return -ENOMEM;
+  }
+
+  for (i = 0; i < links; i++) {
+    yahdlc_multilink_reset(multilink, i);
+  }
+
+  return 0;
+}
+
+void yahdlc_multilink_free(yahdlc_multilink_t *multilink) {
+  if (!multilink) {
+    return;
+  }
+
+  free(multilink->fcs);
+  free(multilink->index);
+  free(multilink->flags);
+  free(multilink->address);
+  free(multilink->control);
+  free(multilink->buffers);
+  memset(multilink, 0, sizeof(*multilink));
+}
+
+void yahdlc_multilink_reset(yahdlc_multilink_t *multilink, unsigned int link) {
+  if (!multilink || (link >= multilink->links)) {
+    return;
+  }
+
+  multilink->fcs[link] = FCS_INIT_VALUE;
+  multilink->index[link] = 0;
+  multilink->flags[link] = 0;
+}
+
+static void yahdlc_multilink_load(const yahdlc_multilink_t *multilink,
+                                  yahdlc_multilink_lane_t *lane,
+                                  const yahdlc_multilink_input_t *input) {
+  lane->link = input->link;
+  lane->fcs = multilink->fcs[input->link];
+  lane->index = multilink->index[input->link];
+  lane->flags = multilink->flags[input->link];
+  lane->address = multilink->address[input->link];
+  lane->control = multilink->control[input->link];
+  lane->buffer = &multilink->buffers[input->link
+      * (multilink->buffer_size + sizeof(FCS_SIZE))];
+  lane->src = input->src;
+  lane->src_len = input->src_len;
+}
+
+static void yahdlc_multilink_store(yahdlc_multilink_t *multilink,
+                                   const yahdlc_multilink_lane_t *lane) {
+  multilink->fcs[lane->link] = lane->fcs;
+  multilink->index[lane->link] = lane->index;
+  multilink->flags[lane->link] = lane->flags;
+  multilink->address[lane->link] = lane->address;
+  multilink->control[lane->link] = lane->control;
+}
+
+static void yahdlc_multilink_end(yahdlc_multilink_lane_t *lane,
+                                 yahdlc_multilink_frame_t frame, void *arg,
+                                 int *frames) {
+  int status = 0;
+  unsigned int len = 0;
+  yahdlc_control_t control = yahdlc_get_control_type(lane->control);
+
+  // A frame contains at least the address, control and FCS fields and has a valid FCS value
+  if (lane->flags & YAHDLC_MULTILINK_OVERFLOW) {
+    status = -ENOBUFS;
+  } else if ((lane->index < (2 + sizeof(FCS_SIZE)))
+      || (lane->fcs != FCS_GOOD_VALUE)) {
+    status = -EIO;
+  } else {
+    len = lane->index - 2 - sizeof(FCS_SIZE);
+    (*frames)++;
+  }
+
+  frame(arg, lane->link, lane->address, &control, lane->buffer, len, status);
+}
+
+static inline void yahdlc_multilink_value(unsigned int buffer_size,
+                                          yahdlc_multilink_lane_t *lane,
+                                          char value,
+                                          yahdlc_multilink_frame_t frame,
+                                          void *arg, int *frames) {
+  if (value == YAHDLC_FLAG_SEQUENCE) {
+    // A control escape followed by a flag sequence aborts the frame, and
+    // additional flag sequences (without any value in between) are discarded
+    if (((lane->flags & YAHDLC_MULTILINK_ESCAPE) == 0) && lane->index) {
+      yahdlc_multilink_end(lane, frame, arg, frames);
+    }
+
+    // Every flag sequence can be the start of the next frame
+    lane->fcs = FCS_INIT_VALUE;
+    lane->index = 0;
+    lane->flags = YAHDLC_MULTILINK_IN_FRAME;
+  } else if (!(lane->flags & YAHDLC_MULTILINK_IN_FRAME)) {
+    // Discard everything until the first flag sequence
+  } else if (value == YAHDLC_CONTROL_ESCAPE) {
+    lane->flags |= YAHDLC_MULTILINK_ESCAPE;
+  } else {
+    if (lane->flags & YAHDLC_MULTILINK_ESCAPE) {
+      lane->flags &= ~YAHDLC_MULTILINK_ESCAPE;
+      value ^= 0x20;
+    }
+
+    lane->fcs = calc_fcs(lane->fcs, value);
+
+    if (lane->index == 0) {
+      lane->address = value;
+    } else if (lane->index == 1) {
+      lane->control = value;
+    } else if ((lane->index - 2) < (buffer_size + sizeof(FCS_SIZE))) {
+      lane->buffer[lane->index - 2] = value;
+    } else {
+      // Keep the index but drop the frame when it ends
+      lane->flags |= YAHDLC_MULTILINK_OVERFLOW;
+      return;
+    }
+
+    lane->index++;
+  }
+}
+
+int yahdlc_multilink_get_data(yahdlc_multilink_t *multilink,
+                              const yahdlc_multilink_input_t *inputs,
+                              unsigned int inputs_len,
+                              yahdlc_multilink_frame_t frame, void *arg) {
+  int frames = 0;
+  unsigned int i, j, k, len, lanes_len, buffer_size;
+  yahdlc_multilink_lane_t lanes[YAHDLC_MULTILINK_LANES];
+
+  // Make sure that all parameters are valid before anything is decoded
+  if (!multilink || !multilink->links || (!inputs && inputs_len) || !frame) {
+    return -EINVAL;
+  }
+
+  for (i = 0; i < inputs_len; i++) {
+    if ((inputs[i].link >= multilink->links)
+        || (!inputs[i].src && inputs[i].src_len)) {
+      return -EINVAL;
+    }
+  }
+
+  buffer_size = multilink->buffer_size;
+
+  for (i = 0; i < inputs_len; i += lanes_len) {
+    // Take the next chunks as lanes until a link repeats, as chunks of the
+    // same link have to be decoded one after another
+    for (lanes_len = 0; (lanes_len < YAHDLC_MULTILINK_LANES)
+        && ((i + lanes_len) < inputs_len); lanes_len++) {
+      for (k = 0; k < lanes_len; k++) {
+        if (lanes[k].link == inputs[i + lanes_len].link) {
+          break;
+        }
+      }
+
+      if (k < lanes_len) {
+        break;
+      }
+
+      yahdlc_multilink_load(multilink, &lanes[lanes_len], &inputs[i + lanes_len]);
+    }
+
+    // Decode the common length of a full set of lanes interleaved
+    len = 0;
+    if (lanes_len == YAHDLC_MULTILINK_LANES) {
+      len = lanes[0].src_len;
+      for (k = 1; k < YAHDLC_MULTILINK_LANES; k++) {
+        if (lanes[k].src_len < len) {
+          len = lanes[k].src_len;
+        }
+      }
+
+      for (j = 0; j < len; j++) {
+        yahdlc_multilink_value(buffer_size, &lanes[0], lanes[0].src[j], frame, arg, &frames);
+        yahdlc_multilink_value(buffer_size, &lanes[1], lanes[1].src[j], frame, arg, &frames);
+        yahdlc_multilink_value(buffer_size, &lanes[2], lanes[2].src[j], frame, arg, &frames);
+        yahdlc_multilink_value(buffer_size, &lanes[3], lanes[3].src[j], frame, arg, &frames);
+      }
+    }
+
+    // Decode the rest of each lane on its own
+    for (k = 0; k < lanes_len; k++) {
+      for (j = len; j < lanes[k].src_len; j++) {
+        yahdlc_multilink_value(buffer_size, &lanes[k], lanes[k].src[j], frame, arg, &frames);
+      }
+
+      yahdlc_multilink_store(multilink, &lanes[k]);
+    }
+  }
+
+  return frames;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file yahdlc_multilink.h
+ */
+
+#ifndef YAHDLC_MULTILINK_H
+#define YAHDLC_MULTILINK_H
+
+#include "yahdlc.h"
+
+/** Maximum number of links of a multi-link decoder */
+#define YAHDLC_MULTILINK_MAX_LINKS 0x10000
+
+/** Per-link flags */
+#define YAHDLC_MULTILINK_IN_FRAME 0x01
+#define YAHDLC_MULTILINK_ESCAPE 0x02
+#define YAHDLC_MULTILINK_OVERFLOW 0x04
+
+/** Chunk of received data for a single link */
+typedef struct {
+  unsigned int link;
+  const char *src;
+  unsigned int src_len;
+} yahdlc_multilink_input_t;
+
+/**
+ * Called for every frame found by @ref yahdlc_multilink_get_data. The data is
+ * only valid during the call.
+ *
+ * @param arg Argument given to yahdlc_multilink_get_data
+ * @param link Link of the frame
+ * @param address Address field of the frame
+ * @param control Control field structure with frame type and sequence number
+ * @param data Frame data
+ * @param data_len Frame data length
+ * @param status 0 on success, -EIO on invalid FCS or -ENOBUFS if the frame
+ * did not fit into the link buffer
+ */
+typedef void (*yahdlc_multilink_frame_t)(void *arg, unsigned int link,
+                                         unsigned char address,
+                                         const yahdlc_control_t *control,
+                                         const char *data,
+                                         unsigned int data_len, int status);
+
+/** Decoder state of many links stored as structure of arrays, so the state
+ * of a link is a few bytes (FCS, 16-bit value index, flags, address and
+ * control field) plus its buffer
+ */
+typedef struct {
+  unsigned int links;
+  unsigned int buffer_size;
+  FCS_SIZE *fcs;
+  unsigned short *index;
+  unsigned char *flags;
+  unsigned char *address;
+  unsigned char *control;
+  char *buffers;
+} yahdlc_multilink_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocates and resets the decoder state of the links
+ *
+ * @param[out] multilink Multi-link decoder
+ * @param[in] links Number of links
+ * @param[in] buffer_size Size of the buffer of each link (max frame data size)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOMEM Out of memory
+ */
+int yahdlc_multilink_init(yahdlc_multilink_t *multilink, unsigned int links,
+                          unsigned int buffer_size);
+
+/**
+ * Frees the decoder state of the links
+ *
+ * @param[in] multilink Multi-link decoder
+ */
+void yahdlc_multilink_free(yahdlc_multilink_t *multilink);
+
+/**
+ * Resets the decoder state of a single link
+ *
+ * @param[in] multilink Multi-link decoder
+ * @param[in] link Link to be reset
+ */
+void yahdlc_multilink_reset(yahdlc_multilink_t *multilink, unsigned int link);
+
+/**
+ * Decodes a batch of received chunks of data for multiple links. Chunks of
+ * different links are decoded interleaved to overlap the FCS calculations.
+ * Chunks of the same link are decoded in order.
+ *
+ * Frames using COBS stuffing (@ref yahdlc_frame_data_cobs) are not supported.
+ *
+ * @param[in] multilink Multi-link decoder
+ * @param[in] inputs Received chunks
+ * @param[in] inputs_len Number of received chunks
+ * @param[in] frame Function called for every frame found
+ * @param[in] arg Argument passed to frame
+ * @retval >=0 Number of valid frames found
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_multilink_get_data(yahdlc_multilink_t *multilink,
+                              const yahdlc_multilink_input_t *inputs,
+                              unsigned int inputs_len,
+                              yahdlc_multilink_frame_t frame, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,230 @@
+#include "yahdlc_parallel.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Initial number of frames of a chunk, which is doubled whenever it is full
+#define YAHDLC_PARALLEL_FRAMES_INIT 64
+
+// Part of the source buffer decoded by a single worker
+typedef struct {
+  size_t start;
+  size_t end;
+  size_t consumed;
+  yahdlc_frame_info_t *frames;
+  unsigned int frames_len;
+  unsigned int frames_size;
+  int error;
+} yahdlc_chunk_t;
+
+// Shared between the workers which take the next undecoded chunk when done
+typedef struct {
+  const char *src;
+  char *dest;
+  yahdlc_chunk_t *chunks;
+  size_t chunks_len;
+  size_t next_chunk;
+  pthread_mutex_t lock;
+} yahdlc_parallel_t;
+
+static int yahdlc_add_frame(yahdlc_chunk_t *chunk, yahdlc_control_t *control,
+                            size_t offset, unsigned int length, int status) {
+  unsigned int size;
+  yahdlc_frame_info_t *frames, *frame;
+
+  // Grow the frames as they are found, so the memory needed depends on the
+  // number of frames and not on the chunk size
+  if (chunk->frames_len == chunk->frames_size) {
+    size = chunk->frames_size ? (2 * chunk->frames_size) : YAHDLC_PARALLEL_FRAMES_INIT;
+    frames = realloc(chunk->frames, size * sizeof(yahdlc_frame_info_t));
+    if (!frames) {
+      return -ENOMEM;
+    }
+    chunk->frames = frames;
+    chunk->frames_size = size;
+  }
+
+  frame = &chunk->frames[chunk->frames_len++];
+  if (control) {
+    frame->control = *control;
+  } else {
+    memset(&frame->control, 0, sizeof(frame->control));
+  }
+  frame->offset = offset;
+  frame->length = length;
+  frame->status = status;
+
+  return 0;
+}
+
+static void yahdlc_decode_chunk(const char *src, char *dest,
+                                yahdlc_chunk_t *chunk) {
+  int ret;
+  unsigned int dest_len;
+  size_t len, pos = chunk->start, frame = chunk->start;
+  yahdlc_state_t state;
+  yahdlc_control_t control;
+
+  yahdlc_get_data_reset_with_state(&state);
+  chunk->consumed = chunk->start;
+
+  while (pos < chunk->end) {
+    // The decoder returns the discarded size as an int, so larger chunks are
+    // passed in pieces which continue the frame kept in the state
+    len = chunk->end - pos;
+    if (len > INT_MAX) {
+      len = INT_MAX;
+    }
+
+    // The decoded data is written at the same offset as the frame in the source
+    // buffer which makes sure that the chunks never overlap in the destination
+    ret = yahdlc_get_data_with_state(&state, &control, &src[pos], len,
+                                     &dest[frame], &dest_len);
+    if (ret >= 0) {
+      chunk->error = yahdlc_add_frame(chunk, &control, frame, dest_len, 0);
+      pos += ret;
+    } else if (ret == -EIO) {
+      // The control field of a frame with an invalid FCS can not be trusted
+      chunk->error = yahdlc_add_frame(chunk, NULL, frame, 0, ret);
+      pos += dest_len;
+    } else if (len < (chunk->end - pos)) {
+      // Continue the frame with the next piece of the chunk
+      pos += len;
+      continue;
+    } else {
+      // No more complete frames in this chunk
+      break;
+    }
+
+    if (chunk->error) {
+      return;
+    }
+
+    chunk->consumed = pos;
+    frame = pos;
+  }
+}
+
+static void *yahdlc_parallel_worker(void *arg) {
+  size_t i;
+  yahdlc_parallel_t *parallel = arg;
+
+  for (;;) {
+    pthread_mutex_lock(&parallel->lock);
+    i = parallel->next_chunk++;
+    pthread_mutex_unlock(&parallel->lock);
+
+    if (i >= parallel->chunks_len) {
+      break;
+    }
+
+    yahdlc_decode_chunk(parallel->src, parallel->dest, &parallel->chunks[i]);
+  }
+
+  return NULL;
+}
+
+long yahdlc_get_data_parallel(const char *src, size_t src_len, char *dest,
+                              yahdlc_frame_info_t *frames,
+                              unsigned int *frames_len, unsigned int threads,
+                              size_t chunk_size) {
+  long ret = 0;
+  const char *flag;
+  size_t i, start, frames_count = 0;
+  pthread_t *workers;
+  yahdlc_parallel_t parallel;
+
+  // Make sure that all parameters are valid
+  if (!src || !dest || !frames || !frames_len) {
+    return -EINVAL;
+  }
+
+  if (!threads) {
+    threads = (unsigned int) sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  if (!chunk_size) {
+    chunk_size = YAHDLC_PARALLEL_CHUNK_SIZE;
+  }
+
+  memset(&parallel, 0, sizeof(parallel));
+  parallel.src = src;
+  parallel.dest = dest;
+  parallel.chunks = calloc((src_len / chunk_size) + 1, sizeof(yahdlc_chunk_t));
+  if (!parallel.chunks) {
+    return -ENOMEM;
+  }
+
+  // Partition the buffer at the first flag sequence after each chunk size. The
+  // flag sequence is included in both chunks as it ends the last frame of one
+  // chunk and starts the first frame of the next.
+  for (start = 0; start < src_len;) {
+    parallel.chunks[parallel.chunks_len].start = start;
+
+    flag = NULL;
+    if ((src_len - start) > chunk_size) {
+      flag = memchr(&src[start + chunk_size], YAHDLC_FLAG_SEQUENCE,
+                    src_len - start - chunk_size);
+    }
+
+    if (flag) {
+      start = flag - src;
+      parallel.chunks[parallel.chunks_len++].end = start + 1;
+    } else {
+      start = src_len;
+      parallel.chunks[parallel.chunks_len++].end = src_len;
+    }
+  }
+
+  if (threads > parallel.chunks_len) {
+    threads = parallel.chunks_len;
+  }
+
+  // Decode the chunks using the calling thread and the additional workers
+  workers = calloc(threads + 1, sizeof(pthread_t));
+  pthread_mutex_init(&parallel.lock, NULL);
+  for (i = 1; workers && (i < threads); i++) {
+    if (pthread_create(&workers[i], NULL, yahdlc_parallel_worker, &parallel)) {
+      break;
+    }
+  }
+  yahdlc_parallel_worker(&parallel);
+  while (workers && (--i > 0)) {
+    pthread_join(workers[i], NULL);
+  }
+  pthread_mutex_destroy(&parallel.lock);
+  free(workers);
+
+  // Merge the frames of the chunks in order
+  for (i = 0; i < parallel.chunks_len; i++) {
+    if (parallel.chunks[i].error) {
+      ret = parallel.chunks[i].error;
+    } else if (!ret && parallel.chunks[i].frames_len) {
+      if ((frames_count + parallel.chunks[i].frames_len) > *frames_len) {
+        ret = -ENOBUFS;
+      } else {
+        memcpy(&frames[frames_count], parallel.chunks[i].frames,
+               parallel.chunks[i].frames_len * sizeof(yahdlc_frame_info_t));
+        frames_count += parallel.chunks[i].frames_len;
+      }
+    }
+    free(parallel.chunks[i].frames);
+  }
+
+  if (!ret) {
+    *frames_len = frames_count;
+
+    // Everything up to the end of the last complete frame should be discarded
+    for (i = parallel.chunks_len; i > 0; i--) {
+      if (parallel.chunks[i - 1].frames_len) {
+        ret = parallel.chunks[i - 1].consumed;
+        break;
+      }
+    }
+  }
+
+  free(parallel.chunks);
+  return ret;
+}
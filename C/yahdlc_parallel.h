@@ -0,0 +1,61 @@
+/**
+ * @file yahdlc_parallel.h
+ */
+
+#ifndef YAHDLC_PARALLEL_H
+#define YAHDLC_PARALLEL_H
+
+#include "yahdlc.h"
+#include <stddef.h>
+
+/** Default size of the chunks a buffer is partitioned into before decoding */
+#ifndef YAHDLC_PARALLEL_CHUNK_SIZE
+#define YAHDLC_PARALLEL_CHUNK_SIZE (1024 * 1024)
+#endif
+
+/** Information about a single frame found by yahdlc_get_data_parallel */
+typedef struct {
+  yahdlc_control_t control;
+  size_t offset;
+  unsigned int length;
+  int status;
+} yahdlc_frame_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Retrieves all frames from a large buffer (e.g. a memory-mapped capture file)
+ * using multiple threads. As the flag sequence can only appear as a frame
+ * delimiter the buffer is partitioned at flag sequences and the chunks are
+ * decoded independently, so no frame spans two chunks. The frames are
+ * returned in the order they appear in the source buffer.
+ *
+ * The data of each frame is written to dest at the returned offset. As decoded
+ * data is never larger than the encoded frame, dest must be at least src_len
+ * bytes in size. Frames with an invalid FCS are returned with status -EIO,
+ * a length of 0 and a zeroed control field.
+ *
+ * @param[in] src Source buffer with frames
+ * @param[in] src_len Source buffer length
+ * @param[out] dest Destination buffer (should be at least src_len in size)
+ * @param[out] frames Array receiving information about the decoded frames
+ * @param[in,out] frames_len Size of frames array in, number of frames out
+ * @param[in] threads Number of threads to use (0 for the number of online cores)
+ * @param[in] chunk_size Partition size (0 for YAHDLC_PARALLEL_CHUNK_SIZE)
+ * @retval >=0 Success (size of returned value should be discarded from source buffer)
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOMEM Out of memory
+ * @retval -ENOBUFS Frames array is too small to contain all frames
+ */
+long yahdlc_get_data_parallel(const char *src, size_t src_len, char *dest,
+                              yahdlc_frame_info_t *frames,
+                              unsigned int *frames_len, unsigned int threads,
+                              size_t chunk_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
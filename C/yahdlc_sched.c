@@ -0,0 +1,105 @@
+#include "yahdlc_sched.h"
+#include <string.h>
+
+void yahdlc_sched_init(yahdlc_sched_t *sched) {
+  memset(sched, 0, sizeof(*sched));
+}
+
+int yahdlc_sched_submit(yahdlc_sched_t *sched, yahdlc_sched_frame_t *frame,
+                        const char *data, unsigned int len,
+                        unsigned int priority) {
+  // Make sure that all parameters are valid
+  if (!sched || !frame || !data || !len
+      || (priority >= YAHDLC_SCHED_PRIORITIES)) {
+    return -EINVAL;
+  }
+
+  frame->data = data;
+  frame->len = len;
+  frame->offset = 0;
+  frame->priority = priority;
+  frame->done = 0;
+  frame->next = NULL;
+
+  // Append the frame to the queue of its priority
+  if (sched->tail[priority]) {
+    sched->tail[priority]->next = frame;
+  } else {
+    sched->head[priority] = frame;
+  }
+  sched->tail[priority] = frame;
+
+  return 0;
+}
+
+static yahdlc_sched_frame_t *yahdlc_sched_next(yahdlc_sched_t *sched,
+                                               unsigned int priorities) {
+  unsigned int i;
+
+  for (i = 0; i < priorities; i++) {
+    if (sched->head[i]) {
+      return sched->head[i];
+    }
+  }
+
+  return NULL;
+}
+
+unsigned int yahdlc_sched_pull(yahdlc_sched_t *sched, char *dest,
+                               unsigned int dest_len) {
+  unsigned int len, dest_index = 0;
+  yahdlc_sched_frame_t *frame;
+  static const char abort_sequence[YAHDLC_SCHED_ABORT_SIZE] = {
+      YAHDLC_CONTROL_ESCAPE, YAHDLC_FLAG_SEQUENCE };
+
+  if (!sched || !dest) {
+    return 0;
+  }
+
+  // Abort the frame being sent if a frame with a higher priority is waiting,
+  // unless it is almost done anyway
+  frame = sched->current;
+  if (frame && ((frame->len - frame->offset) > YAHDLC_SCHED_ABORT_SIZE)
+      && yahdlc_sched_next(sched, frame->priority)) {
+    frame->offset = 0;
+    sched->current = NULL;
+    sched->abort_len = YAHDLC_SCHED_ABORT_SIZE;
+  }
+
+  while (dest_index < dest_len) {
+    // Finish sending any abort sequence (also when split over multiple calls)
+    if (sched->abort_len) {
+      dest[dest_index++] = abort_sequence[YAHDLC_SCHED_ABORT_SIZE - sched->abort_len--];
+      continue;
+    }
+
+    if (!sched->current) {
+      sched->current = yahdlc_sched_next(sched, YAHDLC_SCHED_PRIORITIES);
+      if (!sched->current) {
+        break;
+      }
+    }
+
+    frame = sched->current;
+    len = frame->len - frame->offset;
+    if (len > (dest_len - dest_index)) {
+      len = dest_len - dest_index;
+    }
+
+    memcpy(&dest[dest_index], &frame->data[frame->offset], len);
+    dest_index += len;
+    frame->offset += len;
+
+    // Remove the frame from its queue when it has been sent
+    if (frame->offset == frame->len) {
+      sched->head[frame->priority] = frame->next;
+      if (!frame->next) {
+        sched->tail[frame->priority] = NULL;
+      }
+      sched->current = NULL;
+      frame->done = 1;
+    }
+  }
+
+  return dest_index;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file yahdlc_sched.h
+ */
+
+#ifndef YAHDLC_SCHED_H
+#define YAHDLC_SCHED_H
+
+#include "yahdlc.h"
+
+/** Number of priority levels (0 is the highest priority) */
+#ifndef YAHDLC_SCHED_PRIORITIES
+#define YAHDLC_SCHED_PRIORITIES 4
+#endif
+
+/** Size of the abort sequence (control escape followed by flag sequence) */
+#define YAHDLC_SCHED_ABORT_SIZE 2
+
+/** A frame queued for transmission. The structure and the frame data are owned
+ * by the caller and must be kept until done is set by the scheduler.
+ */
+typedef struct yahdlc_sched_frame {
+  const char *data;
+  unsigned int len;
+  unsigned int offset;
+  unsigned int priority;
+  char done;
+  struct yahdlc_sched_frame *next;
+} yahdlc_sched_frame_t;
+
+/** Priority transmit scheduler for frames of multiple channels */
+typedef struct {
+  yahdlc_sched_frame_t *head[YAHDLC_SCHED_PRIORITIES];
+  yahdlc_sched_frame_t *tail[YAHDLC_SCHED_PRIORITIES];
+  yahdlc_sched_frame_t *current;
+  unsigned int abort_len;
+} yahdlc_sched_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes the scheduler
+ *
+ * @param[out] sched Scheduler
+ */
+void yahdlc_sched_init(yahdlc_sched_t *sched);
+
+/**
+ * Queues a frame (e.g. created with @ref yahdlc_frame_data_with_address using
+ * the address field as channel id) for transmission. Frames of the same
+ * priority are sent in order.
+ *
+ * @param[in] sched Scheduler
+ * @param[in] frame Frame queue entry
+ * @param[in] data Frame created with yahdlc_frame_data
+ * @param[in] len Frame length
+ * @param[in] priority Priority of the frame (0 is the highest priority)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_sched_submit(yahdlc_sched_t *sched, yahdlc_sched_frame_t *frame,
+                        const char *data, unsigned int len,
+                        unsigned int priority);
+
+/**
+ * Gets the next bytes to be transmitted. When a frame with a higher priority
+ * is queued while a frame is being transmitted, the transmitted frame is
+ * aborted (control escape followed by flag sequence) and sent again from the
+ * start when no frames with a higher priority are queued.
+ *
+ * @param[in] sched Scheduler
+ * @param[out] dest Destination buffer
+ * @param[in] dest_len Destination buffer length
+ * @returns Number of bytes written to dest (0 when there is nothing to send)
+ */
+unsigned int yahdlc_sched_pull(yahdlc_sched_t *sched, char *dest,
+                               unsigned int dest_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
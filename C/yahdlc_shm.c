@@ -0,0 +1,307 @@
+#include "yahdlc_shm.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Record type of a frame and of the padding up to the end of the ring
+#define YAHDLC_SHM_FRAME 0
+#define YAHDLC_SHM_PADDING 1
+
+// Shared memory header. The publisher first moves reserve to the end of the
+// record being written and then head when the record is complete, so
+// subscribers can detect records overwritten while they were copied.
+typedef struct {
+  unsigned int magic;
+  unsigned int capacity;
+  char reserved1[56];
+  unsigned long long reserve;
+  unsigned long long head;
+  char reserved2[48];
+} yahdlc_shm_header_t;
+
+// Header in front of each frame in the ring
+typedef struct {
+  unsigned int length;
+  unsigned char address;
+  unsigned char control;
+  unsigned short type;
+} yahdlc_shm_record_t;
+
+static unsigned int yahdlc_shm_align(unsigned int size) {
+  return (size + YAHDLC_SHM_RECORD_SIZE - 1) & ~(YAHDLC_SHM_RECORD_SIZE - 1);
+}
+
+int yahdlc_shm_init(void *memory, size_t size) {
+  unsigned int capacity = YAHDLC_SHM_RECORD_SIZE;
+  yahdlc_shm_header_t *header = memory;
+
+  // Make sure that all parameters are valid
+  if (!memory || (size < (YAHDLC_SHM_HEADER_SIZE + (2 * YAHDLC_SHM_RECORD_SIZE)))) {
+    return -EINVAL;
+  }
+
+  while (((size_t) capacity * 2) <= (size - YAHDLC_SHM_HEADER_SIZE)
+      && (capacity < 0x80000000)) {
+    capacity *= 2;
+  }
+
+  memset(header, 0, YAHDLC_SHM_HEADER_SIZE);
+  header->capacity = capacity;
+
+  // Publish the magic value last so subscribers never see a partial header
+  __atomic_store_n(&header->magic, YAHDLC_SHM_MAGIC, __ATOMIC_RELEASE);
+  return 0;
+}
+
+int yahdlc_shm_publish(void *memory, unsigned char address,
+                       const yahdlc_control_t *control, const char *data,
+                       unsigned int data_len) {
+  unsigned int position, size, room;
+  unsigned long long head;
+  yahdlc_shm_header_t *header = memory;
+  char *ring = (char *) memory + YAHDLC_SHM_HEADER_SIZE;
+  yahdlc_shm_record_t record;
+
+  // Make sure that all parameters are valid
+  if (!header || (header->magic != YAHDLC_SHM_MAGIC) || !control
+      || (!data && data_len)) {
+    return -EINVAL;
+  }
+
+  if (data_len > ((header->capacity / 2) - YAHDLC_SHM_RECORD_SIZE)) {
+    return -EMSGSIZE;
+  }
+
+  head = header->head;
+  position = head & (header->capacity - 1);
+  room = header->capacity - position;
+  size = YAHDLC_SHM_RECORD_SIZE + yahdlc_shm_align(data_len);
+
+  // Records are never split at the end of the ring
+  if (size > room) {
+    __atomic_store_n(&header->reserve, head + room + size, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memset(&record, 0, sizeof(record));
+    record.type = YAHDLC_SHM_PADDING;
+    memcpy(&ring[position], &record, sizeof(record));
+    head += room;
+    position = 0;
+  } else {
+    __atomic_store_n(&header->reserve, head + size, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+
+  record.length = data_len;
+  record.address = address;
+  record.control = (control->frame << 3) | control->seq_no;
+  record.type = YAHDLC_SHM_FRAME;
+  memcpy(&ring[position], &record, sizeof(record));
+  if (data_len) {
+    memcpy(&ring[position + YAHDLC_SHM_RECORD_SIZE], data, data_len);
+  }
+
+  // Make the complete record visible to the subscribers
+  __atomic_store_n(&header->head, head + size, __ATOMIC_RELEASE);
+  return 0;
+}
+
+// Checks that the memory contains a ring whose capacity fits into the memory
+static int yahdlc_shm_valid(const yahdlc_shm_header_t *header, size_t size) {
+  unsigned int capacity;
+
+  if ((size < YAHDLC_SHM_HEADER_SIZE)
+      || (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != YAHDLC_SHM_MAGIC)) {
+    return 0;
+  }
+
+  capacity = header->capacity;
+  return (capacity >= (2 * YAHDLC_SHM_RECORD_SIZE)) && !(capacity & (capacity - 1))
+      && (capacity <= (size - YAHDLC_SHM_HEADER_SIZE));
+}
+
+int yahdlc_shm_reader_init(yahdlc_shm_reader_t *reader, const void *memory,
+                           size_t size) {
+  const yahdlc_shm_header_t *header = memory;
+
+  // Make sure that all parameters are valid
+  if (!reader || !header || !yahdlc_shm_valid(header, size)) {
+    return -EINVAL;
+  }
+
+  // The capacity is kept so a changed header can not make reads go out of bounds
+  reader->memory = memory;
+  reader->capacity = header->capacity;
+  reader->cursor = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+  reader->overruns = 0;
+  return 0;
+}
+
+static int yahdlc_shm_overrun(yahdlc_shm_reader_t *reader,
+                              const yahdlc_shm_header_t *header) {
+  // Check that the publisher has not started writing over the record
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if ((__atomic_load_n(&header->reserve, __ATOMIC_RELAXED) - reader->cursor)
+      <= reader->capacity) {
+    return 0;
+  }
+
+  // Continue with the next published frame
+  reader->cursor = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+  reader->overruns++;
+  return -EOVERFLOW;
+}
+
+int yahdlc_shm_read(yahdlc_shm_reader_t *reader, unsigned char *address,
+                    yahdlc_control_t *control, char *dest,
+                    unsigned int dest_size, unsigned int *dest_len) {
+  int ret;
+  unsigned int position;
+  unsigned long long head;
+  const yahdlc_shm_header_t *header;
+  const char *ring;
+  yahdlc_shm_record_t record;
+
+  // Make sure that all parameters are valid
+  if (!reader || !reader->memory || !address || !control || !dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  header = reader->memory;
+  ring = (const char *) reader->memory + YAHDLC_SHM_HEADER_SIZE;
+
+  for (;;) {
+    head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    if (head == reader->cursor) {
+      return -EAGAIN;
+    }
+
+    position = reader->cursor & (reader->capacity - 1);
+    memcpy(&record, &ring[position], sizeof(record));
+
+    ret = yahdlc_shm_overrun(reader, header);
+    if (ret) {
+      return ret;
+    }
+
+    if (record.type == YAHDLC_SHM_PADDING) {
+      reader->cursor += reader->capacity - position;
+      continue;
+    }
+
+    if ((record.length > ((reader->capacity / 2) - YAHDLC_SHM_RECORD_SIZE))
+        || ((position + YAHDLC_SHM_RECORD_SIZE + record.length) > reader->capacity)) {
+      // Only a corrupt record can be larger than a published frame or wrap
+      // around the end of the ring
+      reader->cursor = head;
+      reader->overruns++;
+      return -EOVERFLOW;
+    } else if (record.length > dest_size) {
+      reader->cursor += YAHDLC_SHM_RECORD_SIZE + yahdlc_shm_align(record.length);
+      return -ENOBUFS;
+    }
+
+    memcpy(dest, &ring[position + YAHDLC_SHM_RECORD_SIZE], record.length);
+
+    ret = yahdlc_shm_overrun(reader, header);
+    if (ret) {
+      return ret;
+    }
+
+    *address = record.address;
+    control->frame = (yahdlc_frame_t) (record.control >> 3);
+    control->seq_no = record.control & 0x7;
+    *dest_len = record.length;
+    reader->cursor += YAHDLC_SHM_RECORD_SIZE + yahdlc_shm_align(record.length);
+    return 0;
+  }
+}
+
+int yahdlc_shm_create(yahdlc_shm_t *shm, const char *name,
+                      unsigned int capacity) {
+  int fd, ret = 0;
+
+  // Make sure that all parameters are valid
+  if (!shm || !name || (capacity < (2 * YAHDLC_SHM_RECORD_SIZE))
+      || (capacity & (capacity - 1))) {
+    return -EINVAL;
+  }
+
+  shm->size = YAHDLC_SHM_HEADER_SIZE + (size_t) capacity;
+  fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  if (ftruncate(fd, shm->size) < 0) {
+    ret = -errno;
+  } else {
+    shm->memory = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (shm->memory == MAP_FAILED) {
+      ret = -errno;
+    }
+  }
+  close(fd);
+
+  if (ret) {
+    shm->memory = NULL;
+    return ret;
+  }
+
+  return yahdlc_shm_init(shm->memory, shm->size);
+}
+
+int yahdlc_shm_attach(yahdlc_shm_t *shm, const char *name) {
+  int fd, ret = 0;
+  struct stat st;
+
+  // Make sure that all parameters are valid
+  if (!shm || !name) {
+    return -EINVAL;
+  }
+
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return -errno;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    ret = -errno;
+  } else if (st.st_size < YAHDLC_SHM_HEADER_SIZE) {
+    ret = -EINVAL;
+  } else {
+    shm->size = st.st_size;
+    shm->memory = mmap(NULL, shm->size, PROT_READ, MAP_SHARED, fd, 0);
+    if (shm->memory == MAP_FAILED) {
+      ret = -errno;
+    } else if (!yahdlc_shm_valid(shm->memory, shm->size)) {
+      // Not a ring or a ring larger than the shared memory object
+      munmap(shm->memory, shm->size);
+      ret = -EINVAL;
+    }
+  }
+  close(fd);
+
+  if (ret) {
+    shm->memory = NULL;
+  }
+
+  return ret;
+}
+
+void yahdlc_shm_close(yahdlc_shm_t *shm) {
+  if (shm && shm->memory) {
+    munmap(shm->memory, shm->size);
+    shm->memory = NULL;
+  }
+}
+
+int yahdlc_shm_unlink(const char *name) {
+  if (!name) {
+    return -EINVAL;
+  }
+
+  return (shm_unlink(name) < 0) ? -errno : 0;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file yahdlc_shm.h
+ */
+
+#ifndef YAHDLC_SHM_H
+#define YAHDLC_SHM_H
+
+#include "yahdlc.h"
+#include <stddef.h>
+
+/** Magic value at the start of the shared memory ("YSM1") */
+#define YAHDLC_SHM_MAGIC 0x314D5359
+
+/** Size of the shared memory header (magic, capacity and the write positions
+ * on their own cache line)
+ */
+#define YAHDLC_SHM_HEADER_SIZE 128
+
+/** Size of the header in front of each frame in the ring (8-byte aligned) */
+#define YAHDLC_SHM_RECORD_SIZE 8
+
+/** Shared memory object mapped into the process */
+typedef struct {
+  void *memory;
+  size_t size;
+} yahdlc_shm_t;
+
+/** Subscriber following the ring at its own position */
+typedef struct {
+  const void *memory;
+  unsigned int capacity;
+  unsigned long long cursor;
+  unsigned long long overruns;
+} yahdlc_shm_reader_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initializes a ring in the given memory (e.g. shared memory mapped by the
+ * publishing process). The ring capacity is the largest power of two which
+ * fits after the header.
+ *
+ * @param[in] memory Memory for the ring (8-byte aligned)
+ * @param[in] size Memory size
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or memory too small
+ */
+int yahdlc_shm_init(void *memory, size_t size);
+
+/**
+ * Publishes a decoded frame to all subscribers. There must only be a single
+ * publisher, which never waits for the subscribers, so subscribers which fall
+ * behind by more than the ring capacity lose frames.
+ *
+ * @param[in] memory Ring initialized with yahdlc_shm_init
+ * @param[in] address Address field of the frame
+ * @param[in] control Control field structure with frame type and sequence number
+ * @param[in] data Frame data
+ * @param[in] data_len Frame data length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -EMSGSIZE Frame larger than half the ring capacity
+ */
+int yahdlc_shm_publish(void *memory, unsigned char address,
+                       const yahdlc_control_t *control, const char *data,
+                       unsigned int data_len);
+
+/**
+ * Initializes a subscriber which receives the frames published from now on
+ *
+ * @param[out] reader Subscriber
+ * @param[in] memory Ring initialized with yahdlc_shm_init (can be read-only)
+ * @param[in] size Memory size (e.g. the size of the mapped shared memory)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or memory not containing a ring of a
+ * valid capacity within the memory size
+ */
+int yahdlc_shm_reader_init(yahdlc_shm_reader_t *reader, const void *memory,
+                           size_t size);
+
+/**
+ * Copies the next frame published to the ring without any locks. A frame
+ * overwritten by the publisher while it is copied is detected and reported as
+ * overrun, after which the subscriber continues with the next published frame.
+ *
+ * @param[in] reader Subscriber
+ * @param[out] address Address field of the frame
+ * @param[out] control Control field structure with frame type and sequence number
+ * @param[out] dest Destination buffer
+ * @param[in] dest_size Destination buffer size
+ * @param[out] dest_len Frame data length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -EAGAIN No new frame published
+ * @retval -EOVERFLOW Frames lost because the subscriber fell behind (or a
+ * corrupt record was skipped)
+ * @retval -ENOBUFS Frame larger than the destination buffer (the frame is skipped)
+ */
+int yahdlc_shm_read(yahdlc_shm_reader_t *reader, unsigned char *address,
+                    yahdlc_control_t *control, char *dest,
+                    unsigned int dest_size, unsigned int *dest_len);
+
+/**
+ * Creates (or replaces) a POSIX shared memory object with a ring of the given
+ * capacity and maps it for publishing
+ *
+ * @param[out] shm Mapped shared memory
+ * @param[in] name Name of the shared memory object (e.g. "/yahdlc")
+ * @param[in] capacity Ring capacity (power of two)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval <0 Negative errno value from creating the shared memory
+ */
+int yahdlc_shm_create(yahdlc_shm_t *shm, const char *name,
+                      unsigned int capacity);
+
+/**
+ * Maps an existing POSIX shared memory object read-only for subscribing
+ *
+ * @param[out] shm Mapped shared memory
+ * @param[in] name Name of the shared memory object
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter or shared memory not containing a valid ring
+ * @retval <0 Negative errno value from opening the shared memory
+ */
+int yahdlc_shm_attach(yahdlc_shm_t *shm, const char *name);
+
+/**
+ * Unmaps the shared memory (the shared memory object is kept until
+ * yahdlc_shm_unlink is called)
+ *
+ * @param[in] shm Mapped shared memory
+ */
+void yahdlc_shm_close(yahdlc_shm_t *shm);
+
+/**
+ * Removes the POSIX shared memory object
+ *
+ * @param[in] name Name of the shared memory object
+ * @retval 0 Success
+ * @retval <0 Negative errno value
+ */
+int yahdlc_shm_unlink(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
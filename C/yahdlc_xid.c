@@ -0,0 +1,200 @@
+#include "yahdlc_xid.h"
+#include <stddef.h>
+
+// Size of the format identifier, group identifier and 16-bit group length
+#define YAHDLC_XID_HEADER_SIZE 4
+
+static void yahdlc_xid_put_param(unsigned char id, unsigned int value,
+                                 unsigned int size, char *dest,
+                                 unsigned int *dest_index) {
+  dest[(*dest_index)++] = id;
+  dest[(*dest_index)++] = size;
+
+  // Parameter values are sent most significant byte first
+  while (size--) {
+    dest[(*dest_index)++] = (value >> (8 * size)) & 0xFF;
+  }
+}
+
+int yahdlc_xid_encode(const yahdlc_xid_params_t *params, char *dest,
+                      unsigned int *dest_len) {
+  unsigned int dest_index = YAHDLC_XID_HEADER_SIZE;
+
+  // Make sure that all parameters are valid
+  if (!params || !dest || !dest_len || !params->max_info
+      || (params->max_info > 0xFFFF) || !params->window
+      || (params->window > YAHDLC_XID_WINDOW_MAX)) {
+    return -EINVAL;
+  }
+
+  yahdlc_xid_put_param(YAHDLC_XID_PARAM_MAX_INFO, params->max_info, 2, dest,
+                       &dest_index);
+  yahdlc_xid_put_param(YAHDLC_XID_PARAM_WINDOW, params->window, 1, dest,
+                       &dest_index);
+  yahdlc_xid_put_param(YAHDLC_XID_PARAM_FCS, params->fcs_bits, 1, dest,
+                       &dest_index);
+  yahdlc_xid_put_param(YAHDLC_XID_PARAM_COBS, params->cobs ? 1 : 0, 1, dest,
+                       &dest_index);
+
+  dest[0] = YAHDLC_XID_FORMAT_ID;
+  dest[1] = YAHDLC_XID_GROUP_ID;
+  dest[2] = ((dest_index - YAHDLC_XID_HEADER_SIZE) >> 8) & 0xFF;
+  dest[3] = (dest_index - YAHDLC_XID_HEADER_SIZE) & 0xFF;
+  *dest_len = dest_index;
+
+  return 0;
+}
+
+int yahdlc_xid_frame_data(const yahdlc_xid_params_t *params, char *dest,
+                          unsigned int *dest_len) {
+  int ret;
+  unsigned int info_len;
+  char info[YAHDLC_XID_INFO_SIZE];
+  yahdlc_control_t control = { YAHDLC_FRAME_XID, 0 };
+
+  // Make sure that all parameters are valid
+  if (!dest || !dest_len) {
+    return -EINVAL;
+  }
+
+  ret = yahdlc_xid_encode(params, info, &info_len);
+  if (ret) {
+    return ret;
+  }
+
+  return yahdlc_frame_data(&control, info, info_len, dest, dest_len);
+}
+
+int yahdlc_xid_decode(const char *src, unsigned int src_len,
+                      yahdlc_xid_params_t *params) {
+  unsigned int i, group_len, param_len, value;
+  const unsigned char *info = (const unsigned char *) src;
+  unsigned char id;
+
+  // Make sure that all parameters are valid
+  if (!src || !params) {
+    return -EINVAL;
+  }
+
+  if ((src_len < YAHDLC_XID_HEADER_SIZE) || (info[0] != YAHDLC_XID_FORMAT_ID)
+      || (info[1] != YAHDLC_XID_GROUP_ID)) {
+    return -ENOMSG;
+  }
+
+  group_len = (info[2] << 8) | info[3];
+  if (group_len > (src_len - YAHDLC_XID_HEADER_SIZE)) {
+    return -ENOMSG;
+  }
+
+  params->max_info = YAHDLC_XID_MAX_INFO_DEFAULT;
+  params->window = 1;
+  params->fcs_bits = YAHDLC_XID_FCS_BITS;
+  params->cobs = 0;
+
+  info += YAHDLC_XID_HEADER_SIZE;
+  while (group_len) {
+    if (group_len < 2) {
+      return -ENOMSG;
+    }
+
+    id = info[0];
+    param_len = info[1];
+    info += 2;
+    group_len -= 2;
+
+    if (param_len > group_len) {
+      return -ENOMSG;
+    }
+
+    if ((id == YAHDLC_XID_PARAM_MAX_INFO) || (id == YAHDLC_XID_PARAM_WINDOW)
+        || (id == YAHDLC_XID_PARAM_FCS) || (id == YAHDLC_XID_PARAM_COBS)) {
+      // Known parameters are integers of up to 32 bits
+      if (!param_len || (param_len > sizeof(value))) {
+        return -ENOMSG;
+      }
+
+      for (value = 0, i = 0; i < param_len; i++) {
+        value = (value << 8) | info[i];
+      }
+
+      if (id == YAHDLC_XID_PARAM_MAX_INFO) {
+        if (!value || (value > 0xFFFF)) {
+          return -ENOMSG;
+        }
+        params->max_info = value;
+      } else if (id == YAHDLC_XID_PARAM_WINDOW) {
+        if (!value || (value > YAHDLC_XID_WINDOW_MAX)) {
+          return -ENOMSG;
+        }
+        params->window = value;
+      } else if (id == YAHDLC_XID_PARAM_FCS) {
+        if (value > 0xFF) {
+          return -ENOMSG;
+        }
+        params->fcs_bits = value;
+      } else {
+        if (value > 1) {
+          return -ENOMSG;
+        }
+        params->cobs = value;
+      }
+    }
+
+    info += param_len;
+    group_len -= param_len;
+  }
+
+  return 0;
+}
+
+int yahdlc_xid_negotiate(const yahdlc_xid_params_t *local,
+                         const yahdlc_xid_params_t *remote,
+                         yahdlc_xid_params_t *result) {
+  // Make sure that all parameters are valid
+  if (!local || !remote || !result || !local->max_info || !local->window) {
+    return -EINVAL;
+  }
+
+  // The FCS can not be changed at runtime, so both stations need the FCS of
+  // this build
+  if ((local->fcs_bits != YAHDLC_XID_FCS_BITS)
+      || (remote->fcs_bits != YAHDLC_XID_FCS_BITS)) {
+    return -ENOTSUP;
+  }
+
+  result->max_info = (local->max_info < remote->max_info) ?
+      local->max_info : remote->max_info;
+  if (result->max_info > YAHDLC_XID_MAX_INFO_MAX) {
+    result->max_info = YAHDLC_XID_MAX_INFO_MAX;
+  }
+  result->window = (local->window < remote->window) ?
+      local->window : remote->window;
+  if (result->window > YAHDLC_XID_WINDOW_MAX) {
+    result->window = YAHDLC_XID_WINDOW_MAX;
+  }
+  result->fcs_bits = YAHDLC_XID_FCS_BITS;
+  result->cobs = local->cobs && remote->cobs;
+
+  return 0;
+}
+
+int yahdlc_xid_apply(const yahdlc_xid_params_t *result,
+                     yahdlc_fragment_tx_t *tx, yahdlc_fragment_rx_t *rx,
+                     yahdlc_cache_t *cache) {
+  // Make sure that all parameters are valid
+  if (!result || (result->max_info <= YAHDLC_FRAGMENT_HEADER_SIZE)
+      || (result->max_info > YAHDLC_XID_MAX_INFO_MAX) || !result->window
+      || (result->window > YAHDLC_XID_WINDOW_MAX)) {
+    return -EINVAL;
+  }
+
+  // The parameters are checked above, so neither call can fail and the
+  // parameters are never applied partially
+  yahdlc_fragment_reset(tx, rx,
+                        result->max_info - YAHDLC_FRAGMENT_HEADER_SIZE);
+  if (cache) {
+    yahdlc_cache_set_window(cache, result->window);
+  }
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file yahdlc_xid.h
+ */
+
+#ifndef YAHDLC_XID_H
+#define YAHDLC_XID_H
+
+#include "yahdlc.h"
+#include "yahdlc_cache.h"
+#include "yahdlc_fragment.h"
+
+/** XID format identifier of the ISO 8885 general purpose field */
+#define YAHDLC_XID_FORMAT_ID 0x82
+
+/** XID group identifier of the parameter negotiation group */
+#define YAHDLC_XID_GROUP_ID 0x80
+
+/** XID parameter: maximum information field length in bytes (16-bit) */
+#define YAHDLC_XID_PARAM_MAX_INFO 0x06
+
+/** XID parameter: window size in frames (8-bit) */
+#define YAHDLC_XID_PARAM_WINDOW 0x08
+
+/** XID parameter: FCS size in bits (8-bit, 16 or 32) */
+#define YAHDLC_XID_PARAM_FCS 0x0A
+
+/** XID parameter: COBS frames supported (8-bit, 0 or 1, see yahdlc_frame_data_cobs) */
+#define YAHDLC_XID_PARAM_COBS 0x0C
+
+/** Maximum window size with the 3-bit sequence numbers of the control field */
+#define YAHDLC_XID_WINDOW_MAX YAHDLC_CACHE_WINDOW_MAX
+
+/** Size of the information field created by yahdlc_xid_encode */
+#define YAHDLC_XID_INFO_SIZE 17
+
+/** Conservative maximum information field length used with a peer without
+ * XID support (and before the negotiation, so the fragment contexts should be
+ * initialized with a fragment size of YAHDLC_XID_FRAGMENT_SIZE_DEFAULT)
+ */
+#ifndef YAHDLC_XID_MAX_INFO_DEFAULT
+#define YAHDLC_XID_MAX_INFO_DEFAULT 128
+#endif
+
+/** Fragment size of the conservative maximum information field length */
+#define YAHDLC_XID_FRAGMENT_SIZE_DEFAULT (YAHDLC_XID_MAX_INFO_DEFAULT - YAHDLC_FRAGMENT_HEADER_SIZE)
+
+/** Largest maximum information field length this build can use (a fragment
+ * of the configured YAHDLC_FRAGMENT_SIZE_MAX)
+ */
+#define YAHDLC_XID_MAX_INFO_MAX (YAHDLC_FRAGMENT_SIZE_MAX + YAHDLC_FRAGMENT_HEADER_SIZE)
+
+#if (YAHDLC_XID_MAX_INFO_DEFAULT <= YAHDLC_FRAGMENT_HEADER_SIZE) \
+    || (YAHDLC_XID_MAX_INFO_DEFAULT > YAHDLC_XID_MAX_INFO_MAX)
+#error "YAHDLC_XID_MAX_INFO_DEFAULT must fit a fragment of up to YAHDLC_FRAGMENT_SIZE_MAX"
+#endif
+
+/** FCS size in bits of this build */
+#define YAHDLC_XID_FCS_BITS (8 * sizeof(FCS_SIZE))
+
+/** Link parameters exchanged in XID frames */
+typedef struct {
+  unsigned int max_info;
+  unsigned char window;
+  unsigned char fcs_bits;
+  unsigned char cobs;
+} yahdlc_xid_params_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Creates the XID information field with the given link parameters
+ *
+ * @param[in] params Link parameters supported by this station
+ * @param[out] dest Destination buffer (at least YAHDLC_XID_INFO_SIZE bytes)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ */
+int yahdlc_xid_encode(const yahdlc_xid_params_t *params, char *dest,
+                      unsigned int *dest_len);
+
+/**
+ * Creates a XID frame with the given link parameters, which is sent at link
+ * bring-up and answered by the peer with a XID frame of its own parameters
+ *
+ * @param[in] params Link parameters supported by this station
+ * @param[out] dest Destination buffer (at least twice YAHDLC_XID_INFO_SIZE plus the frame overhead)
+ * @param[out] dest_len Destination buffer length
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ *
+ * @see yahdlc_frame_data
+ */
+int yahdlc_xid_frame_data(const yahdlc_xid_params_t *params, char *dest,
+                          unsigned int *dest_len);
+
+/**
+ * Parses the information field of a received XID frame. Parameters not
+ * included by the peer are set to the defaults of a peer without XID support
+ * (YAHDLC_XID_MAX_INFO_DEFAULT, window of one frame, the FCS of this build
+ * and no COBS frames), and unknown parameters are skipped.
+ *
+ * @param[in] src Data of the received XID frame
+ * @param[in] src_len Data length
+ * @param[out] params Link parameters of the peer
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOMSG Invalid information field
+ */
+int yahdlc_xid_decode(const char *src, unsigned int src_len,
+                      yahdlc_xid_params_t *params);
+
+/**
+ * Negotiates the link parameters used by both stations, which is the
+ * smaller maximum information field length (limited to
+ * YAHDLC_XID_MAX_INFO_MAX) and window size. COBS frames are
+ * only used if both stations support them. The FCS is selected at build
+ * time, so the FCS sizes of both stations must match.
+ *
+ * @param[in] local Link parameters supported by this station
+ * @param[in] remote Link parameters received from the peer
+ * @param[out] result Negotiated link parameters
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter
+ * @retval -ENOTSUP FCS size not supported by both stations
+ */
+int yahdlc_xid_negotiate(const yahdlc_xid_params_t *local,
+                         const yahdlc_xid_params_t *remote,
+                         yahdlc_xid_params_t *result);
+
+/**
+ * Applies the negotiated maximum information field length to the fragment
+ * size of the segmentation and reassembly contexts and the negotiated window
+ * size to the retransmission cache. As fragments of different sizes can not
+ * be mixed, the message being sent has to be restarted with
+ * yahdlc_fragment_tx_begin and the incomplete received messages are dropped.
+ * Frames already kept in the cache stay until they are released.
+ *
+ * @param[in] result Negotiated link parameters
+ * @param[out] tx Segmentation context (can be NULL)
+ * @param[out] rx Reassembly context (can be NULL)
+ * @param[out] cache Retransmission cache (can be NULL)
+ * @retval 0 Success
+ * @retval -EINVAL Invalid parameter, information field too small or too large
+ * for a fragment or invalid window size
+ */
+int yahdlc_xid_apply(const yahdlc_xid_params_t *result,
+                     yahdlc_fragment_tx_t *tx, yahdlc_fragment_rx_t *rx,
+                     yahdlc_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif